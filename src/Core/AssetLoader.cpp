@@ -0,0 +1,86 @@
+#include "AssetLoader.h"
+#include "JobSystem.h"
+#include <stdexcept>
+
+namespace MiniRenderer
+{
+	std::unique_ptr<AssetLoader> AssetLoader::s_Instance = nullptr;
+
+	Model* ModelHandle::TryGet() const
+	{
+		switch (GetState())
+		{
+		case AssetState::Ready:
+			return m_Asset->model.get();
+		case AssetState::Failed:
+			if (m_Asset && m_Asset->error)
+				std::rethrow_exception(m_Asset->error);
+			throw std::runtime_error("Model handle doesn't refer to a Model!\n");
+		default:
+			return nullptr;
+		}
+	}
+
+	std::string ModelHandle::GetError() const
+	{
+		if (GetState() != AssetState::Failed)
+			return std::string();
+		if (!m_Asset || !m_Asset->error)
+			return "Model handle doesn't refer to a Model!";
+
+		try
+		{
+			std::rethrow_exception(m_Asset->error);
+		}
+		catch (const std::exception& e)
+		{
+			std::string message = e.what();
+			while (!message.empty() && message.back() == '\n')
+				message.pop_back();
+			return message;
+		}
+		catch (...)
+		{
+			return "Unknown error!";
+		}
+	}
+
+	AssetLoader* AssetLoader::GetInstance()
+	{
+		if (s_Instance == nullptr)
+			s_Instance = std::make_unique<AssetLoader>();
+		return s_Instance.get();
+	}
+
+	ModelHandle AssetLoader::LoadModel(const std::string& path, bool compressVertices)
+	{
+		const std::string key = path + (compressVertices ? "|compressed" : "");
+
+		std::shared_ptr<ModelHandle::Asset> asset;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto loaded = m_Models.find(key);
+			if (loaded != m_Models.end())
+				return loaded->second;
+
+			asset = std::make_shared<ModelHandle::Asset>();
+			m_Models.emplace(key, ModelHandle(asset));
+		}
+
+		JobSystem::GetInstance()->Submit([asset, path, compressVertices]()
+		{
+			try
+			{
+				asset->model = std::make_unique<Model>(path, compressVertices);
+				asset->state.store(AssetState::Ready, std::memory_order_release);
+			}
+			catch (...)
+			{
+				asset->error = std::current_exception();
+				asset->state.store(AssetState::Failed, std::memory_order_release);
+			}
+		});
+
+		return ModelHandle(asset);
+	}
+}
@@ -0,0 +1,68 @@
+// Loads assets on the JobSystem's worker threads so the render loop never waits on them.
+#pragma once
+
+#include "Model.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace MiniRenderer
+{
+	/// @brief State of an asset that is being loaded in the background.
+	enum class AssetState { Loading, Ready, Failed };
+
+	/// @brief Handle to a Model that is being loaded in the background. Copies share the same Model.
+	class ModelHandle
+	{
+	public:
+		ModelHandle() {}
+
+		AssetState GetState() const { return m_Asset ? m_Asset->state.load(std::memory_order_acquire) : AssetState::Failed; }
+
+		/// @brief Returns if the Model is loaded & can be drawn.
+		bool IsReady() const { return GetState() == AssetState::Ready; }
+
+		/// @brief Returns the Model once it is loaded, nullptr while it is loading. Rethrows the error if the load failed.
+		Model* TryGet() const;
+
+		/// @brief Returns the Model once it is loaded, nullptr while it is loading or if the load failed. Never throws.
+		Model* Get() const { return IsReady() ? m_Asset->model.get() : nullptr; }
+
+		/// @brief Returns the message of the error the load failed with, without a trailing newline, or an empty string if it didn't fail.
+		std::string GetError() const;
+
+		/// @brief Returns if both handles refer to the same Model.
+		bool operator ==(const ModelHandle& other) const { return m_Asset == other.m_Asset; }
+	private:
+		friend class AssetLoader;
+
+		struct Asset
+		{
+			std::atomic<AssetState> state{ AssetState::Loading };
+			std::unique_ptr<Model> model;	// Set before state becomes Ready.
+			std::exception_ptr error;	// Set before state becomes Failed.
+		};
+
+		explicit ModelHandle(std::shared_ptr<Asset> asset) : m_Asset(std::move(asset)) {}
+	private:
+		std::shared_ptr<Asset> m_Asset;
+	};
+
+	class AssetLoader
+	{
+	public:
+		static AssetLoader* GetInstance();
+
+		/// @brief Starts loading the Model at path on a worker thread & returns its handle right away.
+		/// Loading the same file with the same settings again returns the handle of the first load.
+		ModelHandle LoadModel(const std::string& path, bool compressVertices = false);
+	private:
+		std::unordered_map<std::string, ModelHandle> m_Models;
+		std::mutex m_Mutex;
+
+		static std::unique_ptr<AssetLoader> s_Instance;
+	};
+}
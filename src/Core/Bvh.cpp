@@ -0,0 +1,267 @@
+#include "Bvh.h"
+#include "OcclusionBuffer.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace MiniRenderer
+{
+	static const uint32_t NO_NODE = 0xFFFFFFFF;
+
+	/// @brief Number of equal slices the centroids are sorted into along an axis when looking for the best split.
+	static const int SAH_BIN_COUNT = 12;
+
+	/// @brief Cost of visiting a node, relative to testing an item.
+	static const float SAH_TRAVERSAL_COST = 1.0f;
+
+	static const BoundingBox EMPTY_BOX = { Vec3f(FLT_MAX, FLT_MAX, FLT_MAX), Vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+
+	void Bvh::Build(const uint32_t* ids, const BoundingBox* boxes, size_t count)
+	{
+		m_Nodes.clear();
+		m_Parents.clear();
+		m_Items.assign(ids, ids + count);
+		m_Centroids.resize(count);
+		m_ItemBoxes.clear();
+		m_ItemLeaves.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (ids[i] >= m_ItemBoxes.size())
+			{
+				m_ItemBoxes.resize(ids[i] + 1, EMPTY_BOX);
+				m_ItemLeaves.resize(ids[i] + 1, NO_NODE);
+			}
+			m_ItemBoxes[ids[i]] = boxes[i];
+			m_Centroids[i] = Vec3f(_mm_mul_ps(_mm_add_ps(boxes[i].min._mValue, boxes[i].max._mValue), _mm_set1_ps(0.5f)));
+		}
+		m_BuiltArea = 0.0f;
+		if (count == 0) return;
+
+		// Nodes are split in the order they are made, the children of a node always come after it.
+		m_Nodes.reserve(count * 2);
+		m_Nodes.push_back({ EMPTY_BOX, 0, (uint32_t)count });
+		m_Parents.push_back(NO_NODE);
+		UpdateBox(0);
+		for (uint32_t node = 0; node < m_Nodes.size(); node++)
+		{
+			if (!Split(node))
+				for (uint32_t i = m_Nodes[node].first; i < m_Nodes[node].first + m_Nodes[node].count; i++)
+					m_ItemLeaves[m_Items[i]] = node;
+		}
+		m_BuiltArea = HalfSurfaceArea(m_Nodes[0].box);
+	}
+
+	bool Bvh::Split(uint32_t node)
+	{
+		const uint32_t first = m_Nodes[node].first, count = m_Nodes[node].count;
+		if (count <= 1) return false;
+
+		BoundingBox centroidBox = EMPTY_BOX;
+		for (uint32_t i = first; i < first + count; i++)
+			centroidBox = MergeBoxes(centroidBox, { m_Centroids[i], m_Centroids[i] });
+
+		// Cost of every split between the bins along every axis, as the area weighted item counts of the two sides.
+		int bestAxis = -1, bestSplit = 0;
+		float bestCost = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float low = centroidBox.min[axis], high = centroidBox.max[axis];
+			if (!(high > low)) continue;
+			const float binScale = SAH_BIN_COUNT / (high - low);
+
+			BoundingBox binBoxes[SAH_BIN_COUNT];
+			uint32_t binCounts[SAH_BIN_COUNT] = {};
+			for (BoundingBox& box : binBoxes) box = EMPTY_BOX;
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				int bin = std::min((int)((m_Centroids[i][axis] - low) * binScale), SAH_BIN_COUNT - 1);
+				binBoxes[bin] = MergeBoxes(binBoxes[bin], m_ItemBoxes[m_Items[i]]);
+				binCounts[bin]++;
+			}
+
+			// Areas & counts of everything right of each split, then sweep from the left.
+			float rightAreas[SAH_BIN_COUNT];
+			uint32_t rightCounts[SAH_BIN_COUNT];
+			BoundingBox right = EMPTY_BOX;
+			uint32_t rightCount = 0;
+			for (int bin = SAH_BIN_COUNT - 1; bin > 0; bin--)
+			{
+				right = MergeBoxes(right, binBoxes[bin]);
+				rightCount += binCounts[bin];
+				rightAreas[bin] = rightCount > 0 ? HalfSurfaceArea(right) : 0.0f;
+				rightCounts[bin] = rightCount;
+			}
+			BoundingBox left = EMPTY_BOX;
+			uint32_t leftCount = 0;
+			for (int split = 1; split < SAH_BIN_COUNT; split++)
+			{
+				left = MergeBoxes(left, binBoxes[split - 1]);
+				leftCount += binCounts[split - 1];
+				if (leftCount == 0 || rightCounts[split] == 0) continue;
+
+				float cost = HalfSurfaceArea(left) * leftCount + rightAreas[split] * rightCounts[split];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		// Keep small nodes a leaf when testing their items is cheaper than visiting two children. Nodes whose
+		// centroids all coincide can't be binned & are halved in place when they are too large for a leaf.
+		const float area = HalfSurfaceArea(m_Nodes[node].box);
+		uint32_t middle;
+		if (bestAxis < 0)
+		{
+			if (count <= MAX_LEAF_ITEMS) return false;
+			middle = first + count / 2;
+		}
+		else
+		{
+			if (count <= MAX_LEAF_ITEMS && (area <= 0.0f || SAH_TRAVERSAL_COST + bestCost / area >= (float)count))
+				return false;
+
+			const float low = centroidBox.min[bestAxis];
+			const float binScale = SAH_BIN_COUNT / (centroidBox.max[bestAxis] - low);
+			middle = first;
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				int bin = std::min((int)((m_Centroids[i][bestAxis] - low) * binScale), SAH_BIN_COUNT - 1);
+				if (bin < bestSplit)
+				{
+					std::swap(m_Items[i], m_Items[middle]);
+					std::swap(m_Centroids[i], m_Centroids[middle]);
+					middle++;
+				}
+			}
+		}
+
+		const uint32_t children = (uint32_t)m_Nodes.size();
+		m_Nodes.push_back({ EMPTY_BOX, first, middle - first });
+		m_Nodes.push_back({ EMPTY_BOX, middle, first + count - middle });
+		m_Parents.push_back(node);
+		m_Parents.push_back(node);
+		m_Nodes[node].first = children;
+		m_Nodes[node].count = 0;
+		UpdateBox(children);
+		UpdateBox(children + 1);
+		return true;
+	}
+
+	void Bvh::UpdateBox(uint32_t node)
+	{
+		Node& n = m_Nodes[node];
+		if (n.count == 0)
+		{
+			n.box = MergeBoxes(m_Nodes[n.first].box, m_Nodes[n.first + 1].box);
+			return;
+		}
+
+		n.box = EMPTY_BOX;
+		for (uint32_t i = n.first; i < n.first + n.count; i++)
+			n.box = MergeBoxes(n.box, m_ItemBoxes[m_Items[i]]);
+	}
+
+	void Bvh::Refit(uint32_t id, const BoundingBox& box)
+	{
+		if (id >= m_ItemLeaves.size() || m_ItemLeaves[id] == NO_NODE) return;
+
+		m_ItemBoxes[id] = box;
+		for (uint32_t node = m_ItemLeaves[id]; node != NO_NODE; node = m_Parents[node])
+			UpdateBox(node);
+
+		// Rebuild from the boxes the items have now once the refitted nodes overlap too much.
+		if (HalfSurfaceArea(m_Nodes[0].box) > m_BuiltArea * 2.0f)
+		{
+			std::vector<uint32_t> ids(m_Items);
+			std::vector<BoundingBox> boxes(ids.size());
+			for (size_t i = 0; i < ids.size(); i++)
+				boxes[i] = m_ItemBoxes[ids[i]];
+			Build(ids.data(), boxes.data(), ids.size());
+		}
+	}
+
+	void Bvh::Cull(const Frustum& frustum, const OcclusionBuffer* occlusion, const Mat4& viewProjection, std::vector<uint32_t>& visible) const
+	{
+		if (m_Nodes.empty()) return;
+
+		// Nodes to visit, with whether their parent was entirely inside the frustum.
+		std::vector<std::pair<uint32_t, bool>> stack;
+		stack.push_back({ 0, false });
+		while (!stack.empty())
+		{
+			const uint32_t node = stack.back().first;
+			bool inside = stack.back().second;
+			stack.pop_back();
+
+			const Node& n = m_Nodes[node];
+			if (!inside)
+			{
+				if (IsOutside(frustum, n.box)) continue;
+				inside = IsInside(frustum, n.box);
+			}
+			if (occlusion != nullptr && !occlusion->IsVisible(n.box, viewProjection)) continue;
+
+			if (n.count == 0)
+			{
+				stack.push_back({ n.first + 1, inside });
+				stack.push_back({ n.first, inside });
+				continue;
+			}
+
+			for (uint32_t i = n.first; i < n.first + n.count; i++)
+			{
+				const BoundingBox& box = m_ItemBoxes[m_Items[i]];
+				if (n.count > 1 && ((!inside && IsOutside(frustum, box)) || (occlusion != nullptr && !occlusion->IsVisible(box, viewProjection))))
+					continue;
+				visible.push_back(m_Items[i]);
+			}
+		}
+	}
+
+	bool Bvh::Raycast(const Vec3f& origin, const Vec3f& direction, float& distance, uint32_t& id, const std::function<bool(uint32_t, float&)>& intersect) const
+	{
+		if (m_Nodes.empty()) return false;
+
+		const Vec3f inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+		bool hit = false;
+
+		// Nodes to visit, with where the ray enters them.
+		std::vector<std::pair<uint32_t, float>> stack;
+		float entry;
+		if (IntersectRay(m_Nodes[0].box, origin, inverseDirection, distance, entry))
+			stack.push_back({ 0, entry });
+		while (!stack.empty())
+		{
+			const uint32_t node = stack.back().first;
+			const float nodeEntry = stack.back().second;
+			stack.pop_back();
+			if (nodeEntry > distance) continue;
+
+			const Node& n = m_Nodes[node];
+			if (n.count == 0)
+			{
+				// Visit the nearer child first by pushing it last.
+				float entries[2];
+				bool hits[2] = { IntersectRay(m_Nodes[n.first].box, origin, inverseDirection, distance, entries[0]),
+								 IntersectRay(m_Nodes[n.first + 1].box, origin, inverseDirection, distance, entries[1]) };
+				const int nearer = hits[1] && (!hits[0] || entries[1] < entries[0]) ? 1 : 0;
+				if (hits[1 - nearer]) stack.push_back({ n.first + 1 - nearer, entries[1 - nearer] });
+				if (hits[nearer]) stack.push_back({ n.first + nearer, entries[nearer] });
+				continue;
+			}
+
+			for (uint32_t i = n.first; i < n.first + n.count; i++)
+			{
+				if (!IntersectRay(m_ItemBoxes[m_Items[i]], origin, inverseDirection, distance, entry)) continue;
+				if (intersect(m_Items[i], distance))
+				{
+					id = m_Items[i];
+					hit = true;
+				}
+			}
+		}
+		return hit;
+	}
+}
@@ -0,0 +1,68 @@
+// Bounding volume hierarchy over the boxes of scene items, for culling & ray queries in less than linear time.
+#pragma once
+
+#include "Maths/Bounds.h"
+#include <functional>
+#include <vector>
+
+namespace MiniRenderer
+{
+	class OcclusionBuffer;
+
+	class Bvh
+	{
+	public:
+		/// @brief Most items in a leaf, larger nodes are always split.
+		static const uint32_t MAX_LEAF_ITEMS = 8;
+
+		/// @brief Builds the hierarchy over count items, item ids[i] bounded by boxes[i], splitting nodes where the
+		/// surface area heuristic says it is cheapest. Ids have to be unique, & a later Refit of an id has to follow a Build having it.
+		void Build(const uint32_t* ids, const BoundingBox* boxes, size_t count);
+
+		/// @brief Moves the item to box, growing or shrinking only the nodes above it. A hierarchy only refitted gets slower to query
+		/// as the items move far from where they were at the Build, so it is rebuilt once its root has grown to twice its size.
+		void Refit(uint32_t id, const BoundingBox& box);
+
+		/// @brief Appends the ids of the items that may be visible to visible: those touching frustum &, if occlusion is given, not hidden in it.
+		/// Nodes outside frustum or hidden are skipped as a whole, nodes inside frustum don't test their items against it again.
+		void Cull(const Frustum& frustum, const OcclusionBuffer* occlusion, const Mat4& viewProjection, std::vector<uint32_t>& visible) const;
+
+		/// @brief Finds the nearest item hit by the ray origin + t * direction with 0 <= t <= distance. Items whose box the ray hits are passed to
+		/// intersect(id, distance), which returns if the item itself is hit nearer than distance & lowers distance to the hit. Nodes are visited
+		/// nearest first & skipped once they are further than the nearest hit. Returns if any item was hit, setting id & distance to it.
+		bool Raycast(const Vec3f& origin, const Vec3f& direction, float& distance, uint32_t& id, const std::function<bool(uint32_t, float&)>& intersect) const;
+
+		/// @brief Returns if the hierarchy has no items.
+		bool IsEmpty() const { return m_Nodes.empty(); }
+	private:
+		/// @brief Node of the hierarchy, a leaf with the items m_Items[first, first + count) or, if count is 0, an inner node with the children first & first + 1.
+		struct Node
+		{
+			BoundingBox box;
+			uint32_t first;
+			uint32_t count;
+		};
+
+		/// @brief Splits the node in two with the binned surface area heuristic, returns false if it is cheaper to keep it a leaf.
+		bool Split(uint32_t node);
+
+		/// @brief Recomputes the box of the node from its items or children.
+		void UpdateBox(uint32_t node);
+	private:
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_Parents;
+
+		/// @brief Ids of the items in leaf order.
+		std::vector<uint32_t> m_Items;
+
+		/// @brief Box & leaf of every item, by id.
+		std::vector<BoundingBox> m_ItemBoxes;
+		std::vector<uint32_t> m_ItemLeaves;
+
+		/// @brief Items of the leaves that are being split, with their centroids, in the same order as m_Items during the Build.
+		std::vector<Vec3f> m_Centroids;
+
+		/// @brief Surface area of the root at the last Build.
+		float m_BuiltArea = 0.0f;
+	};
+}
@@ -56,6 +56,21 @@ namespace MiniRenderer
 		return LookAt(Position, Position + Front, Up);
 	}
 
+	Mat4 Camera::GetProjectionMatrix(float aspectRatio)
+	{
+		Mat4 projection;
+		Perspective(projection, FOV, aspectRatio, NEAR_PLANE, FAR_PLANE);
+		//Orthographic(projection, 10.0f, -10.0f, 10.0f, -10.0f, 0.01f, 20.0f);
+		return projection;
+	}
+
+	Vec3f Camera::GetRayDirection(float x, float y, float aspectRatio)
+	{
+		// The view looks down Front with Right & Up as its x & y axes, & the projection scales x / depth & y / depth by its diagonal.
+		Mat4 projection = GetProjectionMatrix(aspectRatio);
+		return Front + Right * (x / projection(0, 0)) + Up * (y / projection(1, 1));
+	}
+
 	void Camera::UpdateCameraVectors()
 	{
 		// calculate the new Front vector
@@ -17,6 +17,9 @@ namespace MiniRenderer
 	const float PITCH = 0.0f;
 	const float SPEED = 0.01f;
 	const float SENSITIVITY = 0.3f;
+	const float FOV = 45.0f;
+	const float NEAR_PLANE = 0.1f;
+	const float FAR_PLANE = 100.0f;
 
 	class Camera
 	{
@@ -27,6 +30,10 @@ namespace MiniRenderer
 		void ProcessKeyInput(CameraMovementDirection direction, float deltaTime);
 		void ProcessMouseInput(float xoffset, float yoffset);
 		Mat4 GetViewMatrix();
+		Mat4 GetProjectionMatrix(float aspectRatio);
+
+		// Returns the direction(not normalized) of the ray from Position through the point (x, y) of the view in normalized device coordinates.
+		Vec3f GetRayDirection(float x, float y, float aspectRatio);
 	public:
 		// Attributes
 		Vec3f Position;
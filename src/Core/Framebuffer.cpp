@@ -2,11 +2,221 @@
 #include <memory>
 #include <stdexcept>
 #include <cstring>
+#include <algorithm>
+
+// SSE 4.2
+#include <nmmintrin.h>
+#ifdef __AVX2__
+	#include <immintrin.h>
+#endif
+
+#ifdef PLATFORM_WINDOWS
+	#include <malloc.h>
+#else
+	#include <stdlib.h>
+	#include <sys/mman.h>
+#endif
 
 namespace MiniRenderer
 {
+	/// @brief Fills above this many bytes use non-temporal stores, so that a full screen clear does not evict the whole cache.
+	static const size_t STREAMING_FILL_THRESHOLD = 256 * 1024;
+
+	/// @brief Fills count colors starting from dst with the given value, 4 pixels per store.
+	static void FillColors(uint32_t* dst, size_t count, uint32_t value, bool streaming)
+	{
+		// Write single pixels till we reach a 16 byte boundary.
+		while (count > 0 && (reinterpret_cast<uintptr_t>(dst) & 15) != 0)
+		{
+			*dst++ = value;
+			count--;
+		}
+
+		__m128i fill = _mm_set1_epi32((int)value);
+		size_t blocks = count / 4;
+		__m128i* block = reinterpret_cast<__m128i*>(dst);
+		if (streaming)
+		{
+			for (size_t i = 0; i < blocks; i++)
+				_mm_stream_si128(block + i, fill);
+		}
+		else
+		{
+			for (size_t i = 0; i < blocks; i++)
+				_mm_store_si128(block + i, fill);
+		}
+
+		// Remaining pixels.
+		dst += blocks * 4;
+		for (size_t i = 0; i < count % 4; i++)
+			*dst++ = value;
+	}
+
+	/// @brief Divides every 16 bit lane, holding at most 255 * 255, by 255 with rounding.
+	static inline __m128i Div255(__m128i x)
+	{
+		x = _mm_add_epi16(x, _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+	}
+
+	/// @brief Blends 2 pixels, unpacked to 16 bits per channel, src has to have 255 as its alpha channel.
+	/// alpha holds the source alpha of each pixel in all 4 of its lanes.
+	static inline __m128i BlendUnpacked(__m128i src, __m128i dst, __m128i alpha, BlendMode mode)
+	{
+		// Alpha channel: a + dstA * (1 - a) for source over & dstA + a for additive, as the source alpha channel is 255.
+		if (mode == BlendMode::SourceOver)
+			return Div255(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, _mm_sub_epi16(_mm_set1_epi16(255), alpha))));
+		return _mm_add_epi16(dst, Div255(_mm_mullo_epi16(src, alpha)));
+	}
+
+	/// @brief Blends 4 0xAARRGGBB sources into 4 0xAARRGGBB destinations.
+	static inline __m128i Blend4(__m128i src, __m128i dst, BlendMode mode)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaChannel = _mm_set1_epi32((int)0xFF000000);
+
+		// Broadcast the alpha of every pixel to its channels, then set the source alpha to 255.
+		__m128i alpha = _mm_shuffle_epi8(src, _mm_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1));
+		__m128i alphaHigh = _mm_shuffle_epi8(src, _mm_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1));
+		src = _mm_or_si128(src, alphaChannel);
+
+		__m128i low = BlendUnpacked(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero), alpha, mode);
+		__m128i high = BlendUnpacked(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero), alphaHigh, mode);
+		return _mm_packus_epi16(low, high);
+	}
+
+#ifdef __AVX2__
+	/// @brief Divides every 16 bit lane, holding at most 255 * 255, by 255 with rounding.
+	static inline __m256i Div255(__m256i x)
+	{
+		x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+	}
+
+	/// @brief Blends 8 0xAARRGGBB sources into 8 0xAARRGGBB destinations, same as Blend4().
+	static inline __m256i Blend8(__m256i src, __m256i dst, BlendMode mode)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i lowShuffle = _mm256_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1, 3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+		const __m256i highShuffle = _mm256_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1, 11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1);
+
+		__m256i alphaLow = _mm256_shuffle_epi8(src, lowShuffle);
+		__m256i alphaHigh = _mm256_shuffle_epi8(src, highShuffle);
+		src = _mm256_or_si256(src, _mm256_set1_epi32((int)0xFF000000));
+
+		__m256i srcLow = _mm256_unpacklo_epi8(src, zero), srcHigh = _mm256_unpackhi_epi8(src, zero);
+		__m256i dstLow = _mm256_unpacklo_epi8(dst, zero), dstHigh = _mm256_unpackhi_epi8(dst, zero);
+		if (mode == BlendMode::SourceOver)
+		{
+			const __m256i max = _mm256_set1_epi16(255);
+			dstLow = Div255(_mm256_add_epi16(_mm256_mullo_epi16(srcLow, alphaLow), _mm256_mullo_epi16(dstLow, _mm256_sub_epi16(max, alphaLow))));
+			dstHigh = Div255(_mm256_add_epi16(_mm256_mullo_epi16(srcHigh, alphaHigh), _mm256_mullo_epi16(dstHigh, _mm256_sub_epi16(max, alphaHigh))));
+		}
+		else
+		{
+			dstLow = _mm256_add_epi16(dstLow, Div255(_mm256_mullo_epi16(srcLow, alphaLow)));
+			dstHigh = _mm256_add_epi16(dstHigh, Div255(_mm256_mullo_epi16(srcHigh, alphaHigh)));
+		}
+		return _mm256_packus_epi16(dstLow, dstHigh);
+	}
+#endif
+
+	/// @brief Averages the samples of count pixels into 0xAARRGGBB colors, sampleCount(2 or 4) samples per pixel, 4 pixels at a time.
+	static void ResolveRun(const uint32_t* samples, uint32_t* colors, int count, int sampleCount)
+	{
+		int i = 0;
+		if (sampleCount == 2)
+		{
+			// The rounded average of 2 samples is exactly what _mm_avg_epu8 gives.
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 first = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i * 2)));
+				__m128 second = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i * 2 + 4)));
+				__m128i even = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)));
+				__m128i odd = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(colors + i), _mm_avg_epu8(even, odd));
+			}
+		}
+		else
+		{
+			// Sum the channels of the 4 samples of every pixel in 16 bits, then round & divide by 4.
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rounding = _mm_set1_epi16(2);
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i sums[4];
+				for (int pixel = 0; pixel < 4; pixel++)
+				{
+					__m128i pixelSamples = _mm_load_si128(reinterpret_cast<const __m128i*>(samples + (i + pixel) * 4));
+					sums[pixel] = _mm_add_epi16(_mm_unpacklo_epi8(pixelSamples, zero), _mm_unpackhi_epi8(pixelSamples, zero));
+				}
+				__m128i low = _mm_add_epi16(_mm_unpacklo_epi64(sums[0], sums[1]), _mm_unpackhi_epi64(sums[0], sums[1]));
+				__m128i high = _mm_add_epi16(_mm_unpacklo_epi64(sums[2], sums[3]), _mm_unpackhi_epi64(sums[2], sums[3]));
+				low = _mm_srli_epi16(_mm_add_epi16(low, rounding), 2);
+				high = _mm_srli_epi16(_mm_add_epi16(high, rounding), 2);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(colors + i), _mm_packus_epi16(low, high));
+			}
+		}
+
+		// Remaining pixels.
+		for (; i < count; i++)
+		{
+			uint32_t color = 0;
+			for (int channel = 0; channel < 32; channel += 8)
+			{
+				uint32_t sum = 0;
+				for (int sample = 0; sample < sampleCount; sample++)
+					sum += (samples[i * sampleCount + sample] >> channel) & 0xFF;
+				color |= ((sum + sampleCount / 2) / sampleCount) << channel;
+			}
+			colors[i] = color;
+		}
+	}
+
+	void Framebuffer::BlendRun(uint32_t* colors, unsigned char* alphas, const uint32_t* sources, uint32_t constant, int count, BlendMode mode)
+	{
+		// With a separate alpha plane, the padding byte is filled with the destination alpha for the blend & cleared again after it.
+		if (alphas != nullptr)
+			for (int i = 0; i < count; i++)
+				colors[i] = (colors[i] & 0x00FFFFFF) | ((uint32_t)alphas[i] << 24);
+
+		int i = 0;
+#ifdef __AVX2__
+		const __m256i constant8 = _mm256_set1_epi32((int)constant);
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i src = sources != nullptr ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sources + i)) : constant8;
+			__m256i* dst = reinterpret_cast<__m256i*>(colors + i);
+			_mm256_storeu_si256(dst, Blend8(src, _mm256_loadu_si256(dst), mode));
+		}
+#endif
+		const __m128i constant4 = _mm_set1_epi32((int)constant);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i src = sources != nullptr ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(sources + i)) : constant4;
+			__m128i* dst = reinterpret_cast<__m128i*>(colors + i);
+			_mm_storeu_si128(dst, Blend4(src, _mm_loadu_si128(dst), mode));
+		}
+
+		// Blend the remaining pixels one at a time in the low lane.
+		for (; i < count; i++)
+		{
+			__m128i src = _mm_cvtsi32_si128((int)(sources != nullptr ? sources[i] : constant));
+			colors[i] = (uint32_t)_mm_cvtsi128_si32(Blend4(src, _mm_cvtsi32_si128((int)colors[i]), mode));
+		}
+
+		if (alphas != nullptr)
+		{
+			for (int j = 0; j < count; j++)
+			{
+				alphas[j] = (unsigned char)(colors[j] >> 24);
+				colors[j] &= 0x00FFFFFF;
+			}
+		}
+	}
+
 	Framebuffer::Framebuffer(int x, int y, int width, int height)
-		: m_Width(width), m_Height(height), m_Initialized(false)
+		: colorBuffer(nullptr), alphaBuffer(nullptr), sampleBuffer(nullptr), m_Width(width), m_Height(height)
 	{
 		SetFramebufferSize(x, y, m_Width, m_Height);
 	}
@@ -14,14 +224,61 @@ namespace MiniRenderer
 	Framebuffer::~Framebuffer()
 	{
 		// Free the Memory allocated.
-		free(colorBuffer);
-		free(alphaBuffer);
+		Free(m_ColorAllocation);
+		Free(m_AlphaAllocation);
+		Free(m_SampleAllocation);
 	}
 
 	void Framebuffer::CopyBuffers(const Framebuffer& from)
 	{
-		std::memcpy(colorBuffer, from.colorBuffer, m_Width * m_Height * sizeof(uint32_t));
-		std::memcpy(alphaBuffer, from.alphaBuffer, m_Width * m_Height * sizeof(unsigned char));
+		// Only the pixels both framebuffers have are copied.
+		const int width = from.m_Width < m_Width ? from.m_Width : m_Width;
+		const int height = from.m_Height < m_Height ? from.m_Height : m_Height;
+
+		// Pixels outside the copied area keep their pending clear color.
+		if ((width != m_Width || height != m_Height) && m_PendingTiles > 0)
+			ResolveClear();
+
+		if (from.m_PendingTiles == 0 && from.m_Stride == m_Stride && from.m_PaddedHeight == m_PaddedHeight &&
+			from.m_Layout == m_Layout && from.m_PackedAlpha == m_PackedAlpha)
+		{
+			// Same layout, so the padding can be copied along with the rows.
+			std::memcpy(colorBuffer, from.colorBuffer, (size_t)m_Stride * m_PaddedHeight * sizeof(uint32_t));
+			if (!m_PackedAlpha)
+				std::memcpy(alphaBuffer, from.alphaBuffer, (size_t)m_Stride * m_PaddedHeight * sizeof(unsigned char));
+		}
+		else if (from.m_PendingTiles == 0)
+		{
+			// Only the layout or the alpha storage differs, convert it in one go.
+			CopyRegion(from, 0, 0, width, height);
+		}
+		else
+		{
+			// Copy the written tiles & fill the ones that are still waiting on a clear, without touching the source.
+			int tilesX = (width + CLEAR_TILE_SIZE - 1) >> CLEAR_TILE_SHIFT;
+			int tilesY = (height + CLEAR_TILE_SIZE - 1) >> CLEAR_TILE_SHIFT;
+			for (int tileY = 0; tileY < tilesY; tileY++)
+			{
+				int y0 = tileY << CLEAR_TILE_SHIFT;
+				int y1 = y0 + CLEAR_TILE_SIZE < height ? y0 + CLEAR_TILE_SIZE : height;
+				for (int tileX = 0; tileX < tilesX; tileX++)
+				{
+					int x0 = tileX << CLEAR_TILE_SHIFT;
+					int x1 = x0 + CLEAR_TILE_SIZE < width ? x0 + CLEAR_TILE_SIZE : width;
+					if (from.m_TileClearPending[tileY * from.m_TilesX + tileX])
+						FillRegion(x0, y0, x1, y1, from.m_ClearColor, from.m_ClearAlpha);
+					else
+						CopyRegion(from, x0, y0, x1, y1);
+				}
+			}
+		}
+
+		// Every pixel of this framebuffer has been written, so nothing is waiting on a clear anymore.
+		if (m_PendingTiles > 0)
+		{
+			std::fill(m_TileClearPending.begin(), m_TileClearPending.end(), 0);
+			m_PendingTiles = 0;
+		}
 	}
 
 	void Framebuffer::SetFramebufferSize(int x, int y, int width, int height)
@@ -31,73 +288,384 @@ namespace MiniRenderer
 		// Initialize Pixels to hold this many colors.
 		m_Width = width;
 		m_Height = height;
-		
-		if (m_Initialized)
+
+		// Pad every row to the alignment, so that rows start on a cache line & SIMD stores never split.
+		const int pixelsPerAlignment = FRAMEBUFFER_ALIGNMENT / (int)sizeof(uint32_t);
+		m_Stride = (m_Width + pixelsPerAlignment - 1) / pixelsPerAlignment * pixelsPerAlignment;
+
+		// The tiled layout always stores whole micro tiles.
+		// The linear one is padded as well, so that 4x4 block writes at the bottom edge stay inside the planes.
+		m_PaddedHeight = (m_Height + MICRO_TILE_MASK) & ~MICRO_TILE_MASK;
+
+		// Only reallocate if the current planes are too small, shrinking keeps the old memory.
+		size_t pixels = (size_t)m_Stride * m_PaddedHeight;
+		if (pixels * sizeof(uint32_t) > m_ColorAllocation.size)
 		{
-			// If Buffers were already initialized once, we only need to resize them.
-			uint32_t* cB = (uint32_t*)realloc(colorBuffer, m_Width * m_Height * sizeof(uint32_t));
-			if (cB == nullptr)
-				throw std::runtime_error("Failed to resize color buffer.");
-			else
-				colorBuffer = cB;
+			Free(m_ColorAllocation);
+			m_ColorAllocation = Allocate(pixels * sizeof(uint32_t));
+			if (m_ColorAllocation.memory == nullptr)
+				throw std::runtime_error("Failed to allocate color buffer.");
+		}
+		colorBuffer = (uint32_t*)m_ColorAllocation.memory;
 
-			unsigned char* aB = (unsigned char*)realloc(alphaBuffer, m_Width * m_Height * sizeof(unsigned char));
-			if (aB == nullptr)
-				throw std::runtime_error("Failed to resize alpha buffer.");
-			else
-				alphaBuffer = aB;
+		// The alpha plane is only needed if alpha is not packed into the color buffer.
+		if (m_PackedAlpha)
+		{
+			Free(m_AlphaAllocation);
 		}
-		else
+		else if (pixels * sizeof(unsigned char) > m_AlphaAllocation.size)
 		{
-			// Allocate Memory.
-			colorBuffer = (uint32_t*)malloc(m_Width * m_Height * sizeof(uint32_t));
-			alphaBuffer = (unsigned char*)malloc(m_Width * m_Height * sizeof(unsigned char));
-			if (colorBuffer != nullptr && alphaBuffer != nullptr)
-				m_Initialized = true;
-			else
-				throw std::runtime_error("Failed to allocate buffer.");
+			Free(m_AlphaAllocation);
+			m_AlphaAllocation = Allocate(pixels * sizeof(unsigned char));
+			if (m_AlphaAllocation.memory == nullptr)
+				throw std::runtime_error("Failed to allocate alpha buffer.");
+		}
+		alphaBuffer = (unsigned char*)m_AlphaAllocation.memory;
+
+		// The sample plane is only needed if multisampled.
+		if (m_SampleCount == 1)
+		{
+			Free(m_SampleAllocation);
+		}
+		else if (pixels * m_SampleCount * sizeof(uint32_t) > m_SampleAllocation.size)
+		{
+			Free(m_SampleAllocation);
+			m_SampleAllocation = Allocate(pixels * m_SampleCount * sizeof(uint32_t));
+			if (m_SampleAllocation.memory == nullptr)
+				throw std::runtime_error("Failed to allocate sample buffer.");
 		}
+		sampleBuffer = (uint32_t*)m_SampleAllocation.memory;
+
+		// Resize the tile flags to cover the new size.
+		m_TilesX = (m_Width + CLEAR_TILE_SIZE - 1) >> CLEAR_TILE_SHIFT;
+		int tilesY = (m_Height + CLEAR_TILE_SIZE - 1) >> CLEAR_TILE_SHIFT;
+		m_TileClearPending.assign(m_TilesX * tilesY, 0);
+		m_PendingTiles = 0;
+		m_TileSamplesActive.assign(m_TilesX * tilesY, 0);
+		m_ActiveSampleTiles = 0;
 
 		// Set Default Values.
 		Clear();
 	}
 
+	void Framebuffer::SetLayout(FramebufferLayout layout)
+	{
+		if (layout == m_Layout) return;
+
+		// Go through a resize, so that the contents are cleared in the new layout.
+		m_Layout = layout;
+		SetFramebufferSize(0, 0, m_Width, m_Height);
+	}
+
+	void Framebuffer::EnablePackedAlpha(bool packed)
+	{
+		if (packed == m_PackedAlpha) return;
+
+		// Go through a resize, so that the alpha plane is allocated or freed & the contents are cleared.
+		m_PackedAlpha = packed;
+		SetFramebufferSize(0, 0, m_Width, m_Height);
+	}
+
+	void Framebuffer::SetSampleCount(int sampleCount)
+	{
+		if (sampleCount != 1 && sampleCount != 2 && sampleCount != 4)
+			throw std::runtime_error("Unsupported sample count, it has to be 1, 2 or 4.");
+		if (sampleCount == m_SampleCount) return;
+
+		// Go through a resize, so that the sample plane is allocated or freed & the contents are cleared.
+		m_SampleCount = sampleCount;
+		SetFramebufferSize(0, 0, m_Width, m_Height);
+	}
+
+	void Framebuffer::ResolveSamples()
+	{
+		if (m_ActiveSampleTiles == 0) return;
+
+		for (int tile = 0; tile < (int)m_TileSamplesActive.size(); tile++)
+			if (m_TileSamplesActive[tile])
+				ResolveSampleTile(tile);
+	}
+
 	void Framebuffer::SetClearColor(uint32_t clearColor, unsigned char clearAlpha)
 	{
+		// Tiles waiting on the old clear color have to be filled with it first.
+		ResolveClear();
+
 		m_ClearColor = clearColor;
 		m_ClearAlpha = clearAlpha;
 	}
 
 	void Framebuffer::Clear()
 	{
-		uint32_t* pixel = colorBuffer; // Get the first pixel's Color.
-		unsigned char* alpha = alphaBuffer;	// Get the first pixel's alpha value.
+		// Samples are seeded from the cleared pixels again when triangles next write to their tile.
+		if (m_ActiveSampleTiles > 0)
+		{
+			std::fill(m_TileSamplesActive.begin(), m_TileSamplesActive.end(), 0);
+			m_ActiveSampleTiles = 0;
+		}
 
-		for (int pixelno = 0; pixelno < m_Width * m_Height; pixelno++)
+		if (m_FastClear)
 		{
-			*pixel++ = m_ClearColor;
-			*alpha++ = m_ClearAlpha;
+			// Only mark the tiles, they are filled when they are first written to.
+			std::fill(m_TileClearPending.begin(), m_TileClearPending.end(), 1);
+			m_PendingTiles = (int)m_TileClearPending.size();
+			return;
 		}
+
+		size_t pixels = (size_t)m_Stride * m_PaddedHeight;
+		FillColors(colorBuffer, pixels, StoredColor(m_ClearColor, m_ClearAlpha), pixels * sizeof(uint32_t) >= STREAMING_FILL_THRESHOLD);
+		if (!m_PackedAlpha)
+			std::memset(alphaBuffer, m_ClearAlpha, pixels);
+		_mm_sfence();
+
+		if (m_PendingTiles > 0)
+		{
+			std::fill(m_TileClearPending.begin(), m_TileClearPending.end(), 0);
+			m_PendingTiles = 0;
+		}
+	}
+
+	void Framebuffer::ResolveClear()
+	{
+		if (m_PendingTiles == 0) return;
+
+		for (int tile = 0; tile < (int)m_TileClearPending.size(); tile++)
+			if (m_TileClearPending[tile])
+				ClearTile(tile);
 	}
 
 	void Framebuffer::SetPixelColor(int x, int y, uint32_t color, unsigned char alpha)
 	{
 		// Return if the x & y values are out of bounds.
-		if (x > m_Width || x < 0 || y < 0 || y >= m_Height) return;
+		if (x >= m_Width || x < 0 || y < 0 || y >= m_Height) return;
+
+		SetPixelColorUnchecked(x, y, color, alpha);
+	}
+
+	uint32_t* Framebuffer::GetRowPointer(int y, unsigned char** alphaRow)
+	{
+		if (m_Layout != FramebufferLayout::Linear) return nullptr;
+
+		PrepareSpan(0, m_Width, y);
+		if (alphaRow != nullptr)
+			*alphaRow = m_PackedAlpha ? nullptr : alphaBuffer + (size_t)y * m_Stride;
+		return colorBuffer + (size_t)y * m_Stride;
+	}
 
-		// Pixel at (x,y).
-		int position = y * m_Width + x;
+	void Framebuffer::BlendSpan(int x0, int x1, int y, uint32_t color, unsigned char alpha, BlendMode mode)
+	{
+		PrepareSpan(x0, x1, y);
+		uint32_t source = (color & 0x00FFFFFF) | ((uint32_t)alpha << 24);
+		ForEachRun(x0, x1, y, [source, mode](uint32_t* colors, unsigned char* alphas, int count)
+		{
+			BlendRun(colors, alphas, nullptr, source, count, mode);
+		});
+	}
 
-		// If Position is out of bounds, then return.
-		if (position > m_Width * m_Height) return;
+	void Framebuffer::BlendSpan(int x0, int x1, int y, const uint32_t* colors, BlendMode mode)
+	{
+		PrepareSpan(x0, x1, y);
+		const uint32_t* sources = colors;
+		ForEachRun(x0, x1, y, [&sources, mode](uint32_t* colors, unsigned char* alphas, int count)
+		{
+			BlendRun(colors, alphas, sources, 0, count, mode);
+			sources += count;
+		});
+	}
+
+	void Framebuffer::ClearTile(int tile)
+	{
+		int x0 = (tile % m_TilesX) << CLEAR_TILE_SHIFT;
+		int y0 = (tile / m_TilesX) << CLEAR_TILE_SHIFT;
+		int x1 = x0 + CLEAR_TILE_SIZE < m_Width ? x0 + CLEAR_TILE_SIZE : m_Width;
+		int y1 = y0 + CLEAR_TILE_SIZE < m_Height ? y0 + CLEAR_TILE_SIZE : m_Height;
 
-		uint32_t* pixel = colorBuffer; // Get Color of the pixel at (0,0).
-		unsigned char* alphaValue = alphaBuffer; // Get Alpha value of the pixel at (0,0).
+		FillRegion(x0, y0, x1, y1, m_ClearColor, m_ClearAlpha);
+
+		m_TileClearPending[tile] = 0;
+		m_PendingTiles--;
+	}
 
-		// Goto the pixel at (x,y) in our color & alpha buffer and set the values to the given one.
-		pixel += position;
-		alphaValue += position;
-		*pixel = color;
-		*alphaValue = alpha;
+	void Framebuffer::ActivateSampleTile(int tile)
+	{
+		if (m_TileClearPending[tile])
+			ClearTile(tile);
+
+		int x0 = (tile % m_TilesX) << CLEAR_TILE_SHIFT;
+		int y0 = (tile / m_TilesX) << CLEAR_TILE_SHIFT;
+		int x1 = x0 + CLEAR_TILE_SIZE < m_Width ? x0 + CLEAR_TILE_SIZE : m_Width;
+		int y1 = y0 + CLEAR_TILE_SIZE < m_Height ? y0 + CLEAR_TILE_SIZE : m_Height;
+		for (int y = y0; y < y1; y++)
+		{
+			ForEachOffsetRun(x0, x1, y, [this](size_t position, int count)
+			{
+				uint32_t* samples = sampleBuffer + position * m_SampleCount;
+				for (int i = 0; i < count; i++)
+				{
+					uint32_t color = m_PackedAlpha ? colorBuffer[position + i] : (colorBuffer[position + i] & 0x00FFFFFF) | ((uint32_t)alphaBuffer[position + i] << 24);
+					for (int sample = 0; sample < m_SampleCount; sample++)
+						*samples++ = color;
+				}
+			});
+		}
+
+		m_TileSamplesActive[tile] = 1;
+		m_ActiveSampleTiles++;
+	}
+
+	void Framebuffer::ResolveSampleTile(int tile)
+	{
+		int x0 = (tile % m_TilesX) << CLEAR_TILE_SHIFT;
+		int y0 = (tile / m_TilesX) << CLEAR_TILE_SHIFT;
+		int x1 = x0 + CLEAR_TILE_SIZE < m_Width ? x0 + CLEAR_TILE_SIZE : m_Width;
+		int y1 = y0 + CLEAR_TILE_SIZE < m_Height ? y0 + CLEAR_TILE_SIZE : m_Height;
+		for (int y = y0; y < y1; y++)
+		{
+			ForEachOffsetRun(x0, x1, y, [this](size_t position, int count)
+			{
+				ResolveRun(sampleBuffer + position * m_SampleCount, colorBuffer + position, count, m_SampleCount);
+				if (m_PackedAlpha) return;
+
+				// Move the averaged alpha to the alpha plane.
+				for (int i = 0; i < count; i++)
+				{
+					alphaBuffer[position + i] = (unsigned char)(colorBuffer[position + i] >> 24);
+					colorBuffer[position + i] &= 0x00FFFFFF;
+				}
+			});
+		}
+
+		m_TileSamplesActive[tile] = 0;
+		m_ActiveSampleTiles--;
+	}
+
+	void Framebuffer::FillRegion(int x0, int y0, int x1, int y1, uint32_t color, unsigned char alpha)
+	{
+		// Tiles are small & about to be written to, so keep them in cache.
+		uint32_t stored = StoredColor(color, alpha);
+		if (m_Layout == FramebufferLayout::Linear)
+		{
+			for (int y = y0; y < y1; y++)
+			{
+				FillColors(colorBuffer + (size_t)y * m_Stride + x0, x1 - x0, stored, false);
+				if (!m_PackedAlpha)
+					std::memset(alphaBuffer + (size_t)y * m_Stride + x0, alpha, x1 - x0);
+			}
+			return;
+		}
+
+		// Micro tiles next to each other are contiguous, so every row of micro tiles in the region is a single run.
+		int runLength = (((x1 + MICRO_TILE_MASK) & ~MICRO_TILE_MASK) - x0) << MICRO_TILE_SHIFT;
+		for (int y = y0; y < y1; y += MICRO_TILE_SIZE)
+		{
+			size_t start = PixelOffset(x0, y);
+			FillColors(colorBuffer + start, runLength, stored, false);
+			if (!m_PackedAlpha)
+				std::memset(alphaBuffer + start, alpha, runLength);
+		}
+	}
+
+	void Framebuffer::CopyRegion(const Framebuffer& from, int x0, int y0, int x1, int y1)
+	{
+		// Copies count pixels from the given offset of the source to the given offset of this framebuffer, converting the alpha storage.
+		auto copyRun = [this, &from](size_t to, size_t source, int count)
+		{
+			std::memcpy(colorBuffer + to, from.colorBuffer + source, count * sizeof(uint32_t));
+			if (!m_PackedAlpha && !from.m_PackedAlpha)
+			{
+				std::memcpy(alphaBuffer + to, from.alphaBuffer + source, count * sizeof(unsigned char));
+			}
+			else if (m_PackedAlpha && !from.m_PackedAlpha)
+			{
+				for (int i = 0; i < count; i++)
+					colorBuffer[to + i] = (colorBuffer[to + i] & 0x00FFFFFF) | ((uint32_t)from.alphaBuffer[source + i] << 24);
+			}
+			else if (!m_PackedAlpha && from.m_PackedAlpha)
+			{
+				for (int i = 0; i < count; i++)
+				{
+					alphaBuffer[to + i] = (unsigned char)(colorBuffer[to + i] >> 24);
+					colorBuffer[to + i] &= 0x00FFFFFF;
+				}
+			}
+		};
+
+		if (m_Layout == from.m_Layout)
+		{
+			if (m_Layout == FramebufferLayout::Linear)
+			{
+				for (int y = y0; y < y1; y++)
+					copyRun((size_t)y * m_Stride + x0, (size_t)y * from.m_Stride + x0, x1 - x0);
+			}
+			else
+			{
+				// Rows of micro tiles are contiguous in both.
+				int runLength = (((x1 + MICRO_TILE_MASK) & ~MICRO_TILE_MASK) - x0) << MICRO_TILE_SHIFT;
+				for (int y = y0; y < y1; y += MICRO_TILE_SIZE)
+					copyRun(PixelOffset(x0, y), from.PixelOffset(x0, y), runLength);
+			}
+			return;
+		}
+
+		// Convert between the layouts one micro tile row at a time, a micro tile row is MICRO_TILE_SIZE contiguous pixels in both.
+		for (int y = y0; y < y1; y++)
+		{
+			for (int x = x0; x < x1; x += MICRO_TILE_SIZE)
+			{
+				int count = x + MICRO_TILE_SIZE <= x1 ? MICRO_TILE_SIZE : x1 - x;
+				copyRun(PixelOffset(x, y), from.PixelOffset(x, y), count);
+			}
+		}
+	}
+
+	Framebuffer::Allocation Framebuffer::Allocate(size_t size) const
+	{
+		Allocation allocation;
+		allocation.size = size;
+
+#ifdef PLATFORM_WINDOWS
+		allocation.memory = _aligned_malloc(size, FRAMEBUFFER_ALIGNMENT);
+#else
+		if (m_HugePages && size >= HUGE_PAGE_SIZE)
+		{
+			// Try explicit huge pages first, this only works if the system has some reserved.
+			size_t hugeSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+			void* memory = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (memory == MAP_FAILED)
+			{
+				// Else fall back to normal pages & ask for them to be backed by transparent huge pages.
+				memory = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (memory != MAP_FAILED)
+					madvise(memory, hugeSize, MADV_HUGEPAGE);
+			}
+
+			if (memory != MAP_FAILED)
+			{
+				allocation.memory = memory;
+				allocation.size = hugeSize;
+				allocation.mapped = true;
+				return allocation;
+			}
+		}
+
+		if (posix_memalign(&allocation.memory, FRAMEBUFFER_ALIGNMENT, size) != 0)
+			allocation.memory = nullptr;
+#endif
+		return allocation;
+	}
+
+	void Framebuffer::Free(Allocation& allocation)
+	{
+		if (allocation.memory == nullptr) return;
+
+#ifdef PLATFORM_WINDOWS
+		_aligned_free(allocation.memory);
+#else
+		if (allocation.mapped)
+			munmap(allocation.memory, allocation.size);
+		else
+			free(allocation.memory);
+#endif
+		allocation = Allocation();
 	}
-}
\ No newline at end of file
+}
@@ -1,8 +1,56 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cstring>
+
+// SSE 4.2
+#include <nmmintrin.h>
 
 namespace MiniRenderer
 {
+	/// @brief Width & Height in pixels of the tiles tracked by the fast clear.
+	const int CLEAR_TILE_SHIFT = 5;
+	const int CLEAR_TILE_SIZE = 1 << CLEAR_TILE_SHIFT;
+
+	/// @brief Alignment in bytes of the framebuffer planes, every row starts at a multiple of this.
+	const int FRAMEBUFFER_ALIGNMENT = 64;
+
+	/// @brief Width & Height in pixels of the micro tiles used by the tiled layout, each micro tile is stored contiguously.
+	const int MICRO_TILE_SHIFT = 3;
+	const int MICRO_TILE_SIZE = 1 << MICRO_TILE_SHIFT;
+	const int MICRO_TILE_MASK = MICRO_TILE_SIZE - 1;
+
+	/// @brief Order in which the pixels are stored in the planes of a Framebuffer.
+	enum class FramebufferLayout
+	{
+		/// Row after row, pixel (x,y) is at y * stride + x.
+		Linear,
+		/// Micro tiles of MICRO_TILE_SIZE x MICRO_TILE_SIZE pixels row after row, pixels inside a micro tile are stored row after row.
+		/// Keeps the pixels a triangle touches close in memory, windows can only show Linear framebuffers.
+		Tiled
+	};
+
+	/// @brief How a color is combined with the color already in the framebuffer.
+	enum class BlendMode
+	{
+		/// Straight alpha "over", color = src * alpha + dst * (1 - alpha).
+		SourceOver,
+		/// color = dst + src * alpha, saturated at 255.
+		Additive
+	};
+
+	/// @brief Planes at least this big in bytes are backed by huge pages, if huge pages are enabled.
+	const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	/// @brief Most samples per pixel of a multisampled Framebuffer.
+	const int MAX_SAMPLE_COUNT = 4;
+
+	/// @brief Positions of the samples of a multisampled pixel, relative to the point a pixel is sampled at without multisampling.
+	/// 4 samples are on a rotated grid, so near horizontal & near vertical edges both get 4 coverage levels.
+	const float SAMPLE_POSITIONS_2X[2][2] = { { 0.25f, 0.25f }, { -0.25f, -0.25f } };
+	const float SAMPLE_POSITIONS_4X[4][2] = { { -0.125f, -0.375f }, { 0.375f, -0.125f }, { -0.375f, 0.125f }, { 0.125f, 0.375f } };
+
 	/// @brief Buffer/Memory used to Hold Color & Alpha Values.
 	class Framebuffer
 	{
@@ -12,6 +60,7 @@ namespace MiniRenderer
 		Framebuffer& operator =(const Framebuffer& other) = delete;
 
 		/// @brief Copies the Color & Alpha buffers from the given framebuffer to this framebuffer.
+		/// Tiles that are still waiting on a fast clear in the given framebuffer are filled with its clear color instead.
 		void CopyBuffers(const Framebuffer& from);
 
 		/// @brief Makes a Frambuffer starting from Screen Coordinate (x,y) to (x+width,y+height).
@@ -21,16 +70,199 @@ namespace MiniRenderer
 		int GetFramebufferWidth() const { return m_Width; }
 		/// @brief Height of Framebuffer.
 		int GetFramebufferHeight() const { return m_Height; }
+		/// @brief Number of pixels between the start of two rows, always a multiple of FRAMEBUFFER_ALIGNMENT bytes.
+		int GetFramebufferStride() const { return m_Stride; }
+
+		/// @brief Changes the order in which pixels are stored, contents are cleared if the layout changes.
+		void SetLayout(FramebufferLayout layout);
+		/// @brief Order in which pixels are stored.
+		FramebufferLayout GetLayout() const { return m_Layout; }
+
+		/// @brief If set to true, alpha is stored in the padding byte of the color buffer as 0xAARRGGBB & there is no alpha buffer.
+		/// Blending then only has to touch one plane. Contents are cleared if the storage changes.
+		void EnablePackedAlpha(bool packed);
+		/// @brief True if alpha is stored in the color buffer.
+		bool IsAlphaPacked() const { return m_PackedAlpha; }
+
+		/// @brief The value written to the color buffer for the given color & alpha.
+		inline uint32_t StoredColor(uint32_t color, unsigned char alpha) const
+		{
+			return m_PackedAlpha ? (color & 0x00FFFFFF) | ((uint32_t)alpha << 24) : color;
+		}
+
+		/// @brief Offset of the pixel (x,y) from the start of the color & alpha planes.
+		inline size_t PixelOffset(int x, int y) const
+		{
+			if (m_Layout == FramebufferLayout::Linear)
+				return (size_t)y * m_Stride + x;
+
+			// Start of the row of micro tiles + start of the micro tile + position inside the micro tile.
+			return ((size_t)(y >> MICRO_TILE_SHIFT) * m_Stride << MICRO_TILE_SHIFT) + ((size_t)(x >> MICRO_TILE_SHIFT) << (2 * MICRO_TILE_SHIFT))
+				+ ((y & MICRO_TILE_MASK) << MICRO_TILE_SHIFT) + (x & MICRO_TILE_MASK);
+		}
+
+		/// @brief Sets the number of samples per pixel triangles are rasterized with, 1(no multisampling), 2 or 4. Contents are cleared if it changes.
+		/// Triangles then write their coverage of every sample to sampleBuffer, with one color per pixel, & ResolveSamples() averages the samples
+		/// into the pixels. Everything else is still written to the pixels directly.
+		void SetSampleCount(int sampleCount);
+		/// @brief Number of samples per pixel.
+		int GetSampleCount() const { return m_SampleCount; }
+
+		/// @brief Averages the samples of every tile triangles were written to since the last resolve into its pixels.
+		/// Pixels written directly in such a tile after the triangles are overwritten, so call this before drawing over the triangles
+		/// & before reading the buffers directly. The Swapchain resolves the backbuffer when it is presented.
+		void ResolveSamples();
+
+		/// @brief If set to true, big planes are allocated on huge pages to reduce TLB misses. Takes effect on the next allocation.
+		void EnableHugePages(bool hugePages) { m_HugePages = hugePages; }
 
 		/// @brief Sets the Clear Color & Alpha of this framebuffer.
 		void SetClearColor(uint32_t clearColor, unsigned char clearAlpha = 255);
 		/// @brief Clears the Framebuffer with the color used in last SetClearColor() call.
+		/// If fast clear is enabled, the tiles are only marked as cleared & are filled on their first write or on ResolveClear().
 		void Clear();
+
+		/// @brief If set to true, Clear() only marks the tiles as cleared instead of writing every pixel.
+		void EnableFastClear(bool fastClear) { m_FastClear = fastClear; }
+
+		/// @brief Fills every tile that is still waiting on a fast clear. Call this before reading the buffers directly.
+		void ResolveClear();
 		
 		/// @brief Sets the Color of the Pixel at the coord (x,y) with the desired color & alpha value.
 		void SetPixelColor(int x, int y, uint32_t color, unsigned char alpha = 255);
 
-		/* All The Pixels on the Screen & their colors.
+		// The functions below do no bounds checking, callers clip once against the framebuffer size & then write.
+
+		/// @brief Sets the Color of the Pixel at the coord (x,y), which has to be inside the framebuffer.
+		inline void SetPixelColorUnchecked(int x, int y, uint32_t color, unsigned char alpha = 255)
+		{
+			PrepareTile(x, y);
+			size_t position = PixelOffset(x, y);
+			colorBuffer[position] = StoredColor(color, alpha);
+			if (!m_PackedAlpha)
+				alphaBuffer[position] = alpha;
+		}
+
+		/// @brief Fills the pixels from (x0,y) to (x1,y), x1 excluded, with the given color & alpha.
+		inline void FillSpan(int x0, int x1, int y, uint32_t color, unsigned char alpha = 255)
+		{
+			PrepareSpan(x0, x1, y);
+			uint32_t stored = StoredColor(color, alpha);
+			ForEachRun(x0, x1, y, [stored, alpha](uint32_t* colors, unsigned char* alphas, int count)
+			{
+				for (int i = 0; i < count; i++)
+					colors[i] = stored;
+				if (alphas != nullptr)
+					std::memset(alphas, alpha, count);
+			});
+		}
+
+		/// @brief Writes the given color & alpha to the pixels of the 4x4 block at (x,y) whose bit is set in mask.
+		/// Bit (row * 4 + column) is the pixel (x + column, y + row), x & y have to be multiples of 4.
+		/// The block may reach into the padding of the framebuffer, but not past it.
+		inline void WriteBlock4x4(int x, int y, uint16_t mask, uint32_t color, unsigned char alpha = 255)
+		{
+			PrepareTile(x, y);
+
+			// A 4x4 block never crosses a micro tile, so its rows are a fixed distance apart in both layouts.
+			size_t position = PixelOffset(x, y);
+			size_t rowPitch = m_Layout == FramebufferLayout::Linear ? m_Stride : MICRO_TILE_SIZE;
+			__m128i fill = _mm_set1_epi32((int)StoredColor(color, alpha));
+			const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+			for (int row = 0; row < 4; row++, position += rowPitch, mask >>= 4)
+			{
+				if ((mask & 0xF) == 0) continue;
+
+				__m128i* pixels = reinterpret_cast<__m128i*>(colorBuffer + position);
+				if ((mask & 0xF) == 0xF)
+				{
+					_mm_store_si128(pixels, fill);
+					if (!m_PackedAlpha)
+						std::memset(alphaBuffer + position, alpha, 4);
+					continue;
+				}
+
+				// Select the covered pixels of this row.
+				__m128i rowMask = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(mask & 0xF), bits), bits);
+				_mm_store_si128(pixels, _mm_blendv_epi8(_mm_load_si128(pixels), fill, rowMask));
+				if (m_PackedAlpha) continue;
+				for (int column = 0; column < 4; column++)
+					if (mask & (1 << column))
+						alphaBuffer[position + column] = alpha;
+			}
+		}
+
+		/// @brief Writes the given color & alpha to the samples of the pixels of the 4x4 block at (x,y) that are covered, for a multisampled framebuffer.
+		/// Bit (row * 4 + column) of masks[sample] is set if the sample of the pixel (x + column, y + row) is covered, there is a mask per sample.
+		/// x & y have to be multiples of 4 & the covered pixels inside the framebuffer.
+		inline void WriteSamples4x4(int x, int y, const uint16_t* masks, uint32_t color, unsigned char alpha = 255)
+		{
+			PrepareSampleTile(x, y);
+
+			uint16_t any = 0, all = 0xFFFF;
+			for (int sample = 0; sample < m_SampleCount; sample++)
+			{
+				any |= masks[sample];
+				all &= masks[sample];
+			}
+
+			size_t position = PixelOffset(x, y);
+			size_t rowPitch = m_Layout == FramebufferLayout::Linear ? m_Stride : MICRO_TILE_SIZE;
+			uint32_t stored = (color & 0x00FFFFFF) | ((uint32_t)alpha << 24);
+			const __m128i fill = _mm_set1_epi32((int)stored);
+			for (int pixel = 0; pixel < 16; pixel++)
+			{
+				if ((any & (1 << pixel)) == 0) continue;
+
+				uint32_t* samples = sampleBuffer + (position + (pixel >> 2) * rowPitch + (pixel & 3)) * m_SampleCount;
+				if (all & (1 << pixel))
+				{
+					// Covered pixels take one store, samples of a pixel are aligned to their size.
+					if (m_SampleCount == 4)
+						_mm_store_si128(reinterpret_cast<__m128i*>(samples), fill);
+					else
+						_mm_storel_epi64(reinterpret_cast<__m128i*>(samples), fill);
+					continue;
+				}
+
+				for (int sample = 0; sample < m_SampleCount; sample++)
+					if (masks[sample] & (1 << pixel))
+						samples[sample] = stored;
+			}
+		}
+
+		/// @brief Writes the given color & alpha to the samples of the pixel at (x,y) whose bit is set in sampleMask, for a multisampled framebuffer.
+		/// The pixel has to be inside the framebuffer.
+		inline void WriteSamplesUnchecked(int x, int y, unsigned int sampleMask, uint32_t color, unsigned char alpha = 255)
+		{
+			PrepareSampleTile(x, y);
+			uint32_t* samples = sampleBuffer + PixelOffset(x, y) * m_SampleCount;
+			uint32_t stored = (color & 0x00FFFFFF) | ((uint32_t)alpha << 24);
+			for (int sample = 0; sample < m_SampleCount; sample++)
+				if (sampleMask & (1u << sample))
+					samples[sample] = stored;
+		}
+
+		/// @brief Blends the given color & alpha into the pixel at (x,y), which has to be inside the framebuffer.
+		inline void BlendPixelUnchecked(int x, int y, uint32_t color, unsigned char alpha, BlendMode mode = BlendMode::SourceOver)
+		{
+			PrepareTile(x, y);
+			size_t position = PixelOffset(x, y);
+			BlendRun(colorBuffer + position, m_PackedAlpha ? nullptr : alphaBuffer + position, nullptr, (color & 0x00FFFFFF) | ((uint32_t)alpha << 24), 1, mode);
+		}
+
+		/// @brief Blends the given color & alpha into the pixels from (x0,y) to (x1,y), x1 excluded, 4 or 8 pixels at a time.
+		void BlendSpan(int x0, int x1, int y, uint32_t color, unsigned char alpha, BlendMode mode = BlendMode::SourceOver);
+
+		/// @brief Blends x1 - x0 colors, with their alpha in the top byte as 0xAARRGGBB, into the pixels from (x0,y) to (x1,y).
+		void BlendSpan(int x0, int x1, int y, const uint32_t* colors, BlendMode mode = BlendMode::SourceOver);
+
+		/// @brief Returns the first pixel of row y, the row is GetFramebufferWidth() pixels followed by padding.
+		/// Only valid for the linear layout, returns nullptr for the tiled one. Pending fast clears of the row are filled.
+		/// alphaRow is set to nullptr if alpha is packed into the color buffer.
+		uint32_t* GetRowPointer(int y, unsigned char** alphaRow = nullptr);
+
+		/* All The Pixels on the Screen & their colors, pixel (x,y) is at colorBuffer + PixelOffset(x, y).
 		   A Single Pixel Contains Color data in this Format
 			   R  G  B  / Padding
 		   0x 00 00 00 / 00
@@ -38,11 +270,113 @@ namespace MiniRenderer
 		*/
 		uint32_t* colorBuffer;
 
-		/* The Alpha Value of all the pixels on the screen.
+		/* The Alpha Value of all the pixels on the screen, nullptr if alpha is packed into the color buffer.
 		   This value does not go to the window directly, this is used between two framebuffers for blending purposes.
 		   Each Alpha Value in this buffer Ranges from 0 to 255.
 		*/
 		unsigned char* alphaBuffer;
+
+		/* The Samples of all the pixels on the screen if multisampled, nullptr if not.
+		   The GetSampleCount() samples of pixel (x,y) follow each other at sampleBuffer + PixelOffset(x, y) * GetSampleCount(),
+		   each as 0xAARRGGBB whether or not alpha is packed. Only valid in the tiles written since the last resolve.
+		*/
+		uint32_t* sampleBuffer;
+	private:
+		/// @brief Memory backing one plane of the Framebuffer.
+		struct Allocation
+		{
+			void* memory = nullptr;
+			size_t size = 0;
+			bool mapped = false;	// True if the memory came from mmap instead of the aligned heap.
+		};
+
+		/// @brief Allocates size bytes aligned to FRAMEBUFFER_ALIGNMENT, on huge pages if they are enabled & size is big enough.
+		Allocation Allocate(size_t size) const;
+
+		/// @brief Frees memory returned by Allocate().
+		static void Free(Allocation& allocation);
+
+		/// @brief Blends count pixels into colors & alphas, alphas is nullptr for packed alpha.
+		/// Source colors are 0xAARRGGBB & come from sources, or are all constant if sources is nullptr.
+		static void BlendRun(uint32_t* colors, unsigned char* alphas, const uint32_t* sources, uint32_t constant, int count, BlendMode mode);
+
+		/// @brief Fills the tile at the given index with the clear color & alpha.
+		void ClearTile(int tile);
+
+		/// @brief Fills the tile containing the pixel (x,y) if it is still waiting on a fast clear.
+		inline void PrepareTile(int x, int y)
+		{
+			if (m_PendingTiles == 0) return;
+
+			int tile = (y >> CLEAR_TILE_SHIFT) * m_TilesX + (x >> CLEAR_TILE_SHIFT);
+			if (m_TileClearPending[tile])
+				ClearTile(tile);
+		}
+
+		/// @brief Fills the tiles touched by the pixels from (x0,y) to (x1,y), x1 excluded, if they are still waiting on a fast clear.
+		inline void PrepareSpan(int x0, int x1, int y)
+		{
+			if (m_PendingTiles == 0) return;
+
+			int row = (y >> CLEAR_TILE_SHIFT) * m_TilesX;
+			for (int tile = row + (x0 >> CLEAR_TILE_SHIFT); tile <= row + ((x1 - 1) >> CLEAR_TILE_SHIFT); tile++)
+				if (m_TileClearPending[tile])
+					ClearTile(tile);
+		}
+
+		/// @brief Seeds the samples of the tile at the given index from its pixels, so that triangles are drawn over what is already there.
+		void ActivateSampleTile(int tile);
+
+		/// @brief Averages the samples of the tile at the given index into its pixels.
+		void ResolveSampleTile(int tile);
+
+		/// @brief Seeds the samples of the tile containing the pixel (x,y) if triangles haven't written to it since the last resolve.
+		inline void PrepareSampleTile(int x, int y)
+		{
+			int tile = (y >> CLEAR_TILE_SHIFT) * m_TilesX + (x >> CLEAR_TILE_SHIFT);
+			if (!m_TileSamplesActive[tile])
+				ActivateSampleTile(tile);
+		}
+
+		/// @brief Calls func(position, count) for every run of contiguous pixels from (x0,y) to (x1,y), x1 excluded.
+		/// position is the offset of the first pixel of the run, see PixelOffset().
+		template <typename Func>
+		inline void ForEachOffsetRun(int x0, int x1, int y, Func func) const
+		{
+			if (m_Layout == FramebufferLayout::Linear)
+			{
+				func((size_t)y * m_Stride + x0, x1 - x0);
+				return;
+			}
+
+			// Every micro tile is a separate run.
+			while (x0 < x1)
+			{
+				int end = (x0 & ~MICRO_TILE_MASK) + MICRO_TILE_SIZE;
+				if (end > x1) end = x1;
+				func(PixelOffset(x0, y), end - x0);
+				x0 = end;
+			}
+		}
+
+		/// @brief Calls func(colors, alphas, count) for every run of contiguous pixels from (x0,y) to (x1,y), x1 excluded.
+		/// alphas is nullptr if alpha is packed into the color buffer.
+		template <typename Func>
+		inline void ForEachRun(int x0, int x1, int y, Func func)
+		{
+			ForEachOffsetRun(x0, x1, y, [this, &func](size_t position, int count)
+			{
+				func(colorBuffer + position, m_PackedAlpha ? nullptr : alphaBuffer + position, count);
+			});
+		}
+
+		/// @brief Fills the rectangle [x0,x1) x [y0,y1) with the given color & alpha.
+		/// In the tiled layout the rectangle is grown to whole micro tiles, so x0 & y0 have to be multiples of MICRO_TILE_SIZE.
+		void FillRegion(int x0, int y0, int x1, int y1, uint32_t color, unsigned char alpha);
+
+		/// @brief Copies the rectangle [x0,x1) x [y0,y1) from the given framebuffer, converting between layouts if needed.
+		/// x0 & y0 have to be multiples of MICRO_TILE_SIZE.
+		void CopyRegion(const Framebuffer& from, int x0, int y0, int x1, int y1);
 	private:
 
 		/// @brief Width of the Framebuffer.
@@ -50,6 +384,27 @@ namespace MiniRenderer
 
 		/// @brief Height of the Framebuffer.
 		int m_Height;
+
+		/// @brief Pixels per row including the padding.
+		int m_Stride = 0;
+
+		/// @brief Rows allocated, the height is padded to whole micro tiles.
+		int m_PaddedHeight = 0;
+
+		/// @brief Order in which pixels are stored.
+		FramebufferLayout m_Layout = FramebufferLayout::Linear;
+
+		/// @brief Memory of the Color, Alpha & Sample planes, planes are only reallocated when a resize needs more than they hold.
+		Allocation m_ColorAllocation, m_AlphaAllocation, m_SampleAllocation;
+
+		/// @brief Samples per pixel, 1 if not multisampled.
+		int m_SampleCount = 1;
+
+		/// @brief If true, alpha is stored in the top byte of the color buffer & the alpha plane is not allocated.
+		bool m_PackedAlpha = false;
+
+		/// @brief If true, big planes are allocated on huge pages.
+		bool m_HugePages = false;
 		
 		/// @brief Clear Color, Default is Black.
 		uint32_t m_ClearColor = 0x000000;
@@ -57,7 +412,22 @@ namespace MiniRenderer
 		/// @brief Clear Alpha, Default is 255.
 		unsigned char m_ClearAlpha = 0xFF;
 
-		/// @brief Tells if this Framebuffer has initialized.
-		bool m_Initialized;
+		/// @brief If true, Clear() defers the filling of pixels to the first write in every tile.
+		bool m_FastClear = false;
+
+		/// @brief Number of tiles in a row of the Framebuffer.
+		int m_TilesX = 0;
+
+		/// @brief Number of tiles that are still waiting on a fast clear.
+		int m_PendingTiles = 0;
+
+		/// @brief One flag per tile, non zero if the tile has been fast cleared but not filled yet.
+		std::vector<unsigned char> m_TileClearPending;
+
+		/// @brief Number of tiles whose samples triangles have written to since the last resolve.
+		int m_ActiveSampleTiles = 0;
+
+		/// @brief One flag per tile, non zero if triangles have written to its samples since the last resolve.
+		std::vector<unsigned char> m_TileSamplesActive;
 	};
-}
\ No newline at end of file
+}
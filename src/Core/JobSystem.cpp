@@ -0,0 +1,119 @@
+#include "JobSystem.h"
+#include <atomic>
+#include <exception>
+
+namespace MiniRenderer
+{
+	std::unique_ptr<JobSystem> JobSystem::s_Instance = nullptr;
+
+	JobSystem::JobSystem(unsigned int threadCount)
+	{
+		if (threadCount == 0)
+		{
+			unsigned int hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		for (unsigned int i = 0; i < threadCount; i++)
+			m_Workers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_JobAvailable.notify_all();
+
+		for (std::thread& worker : m_Workers)
+			worker.join();
+	}
+
+	JobSystem* JobSystem::GetInstance()
+	{
+		if (s_Instance == nullptr)
+			s_Instance = std::make_unique<JobSystem>();
+		return s_Instance.get();
+	}
+
+	void JobSystem::Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push(std::move(job));
+		}
+		m_JobAvailable.notify_one();
+	}
+
+	void JobSystem::ParallelFor(size_t count, const std::function<void(size_t)>& func)
+	{
+		if (count == 0) return;
+
+		// Shared with the helper jobs, which may only start after this call has returned.
+		struct State
+		{
+			std::atomic<size_t> next{ 0 };
+			std::atomic<size_t> done{ 0 };
+			size_t count = 0;
+			std::function<void(size_t)> func;
+			std::mutex mutex;
+			std::condition_variable finished;
+			std::exception_ptr exception;
+		};
+		std::shared_ptr<State> state = std::make_shared<State>();
+		state->count = count;
+		state->func = func;
+
+		// Claims indices till there are none left.
+		auto work = [](State& s)
+		{
+			for (size_t i = s.next++; i < s.count; i = s.next++)
+			{
+				try
+				{
+					s.func(i);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(s.mutex);
+					if (!s.exception) s.exception = std::current_exception();
+				}
+
+				if (++s.done == s.count)
+				{
+					std::lock_guard<std::mutex> lock(s.mutex);
+					s.finished.notify_all();
+				}
+			}
+		};
+
+		size_t helpers = count - 1 < m_Workers.size() ? count - 1 : m_Workers.size();
+		for (size_t i = 0; i < helpers; i++)
+			Submit([state, work]() { work(*state); });
+
+		work(*state);
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&state]() { return state->done == state->count; });
+		if (state->exception)
+			std::rethrow_exception(state->exception);
+	}
+
+	void JobSystem::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_JobAvailable.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+				if (m_Stopping && m_Jobs.empty()) return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop();
+			}
+			job();
+		}
+	}
+}
@@ -0,0 +1,47 @@
+// Pool of worker threads that runs jobs in the background.
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+namespace MiniRenderer
+{
+	class JobSystem
+	{
+	public:
+		/// @brief Starts the given number of worker threads, 0 starts one less than the number of hardware threads.
+		JobSystem(unsigned int threadCount = 0);
+		~JobSystem();
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator =(const JobSystem&) = delete;
+
+		static JobSystem* GetInstance();
+
+		/// @brief Runs the job on one of the worker threads.
+		void Submit(std::function<void()> job);
+
+		/// @brief Calls func(i) for every i in [0, count) on the worker threads & the calling thread, returns once all calls are done.
+		/// The calling thread takes part, so this never waits on workers that are busy with other jobs.
+		/// If a call throws, the first exception is rethrown here after the others are done.
+		void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+		/// @brief Number of threads that can run jobs, the worker threads & the calling thread.
+		unsigned int GetThreadCount() const { return (unsigned int)m_Workers.size() + 1; }
+	private:
+		/// @brief Runs jobs till the JobSystem is destroyed.
+		void WorkerLoop();
+	private:
+		std::vector<std::thread> m_Workers;
+		std::queue<std::function<void()>> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_JobAvailable;
+		bool m_Stopping = false;
+
+		static std::unique_ptr<JobSystem> s_Instance;
+	};
+}
@@ -1,20 +1,102 @@
-// Renders a line based on Bresenham's Line Rendering algorithm
+// Renders a line based on Bresenham's Line Rendering algorithm, or anti-aliased based on Xiaolin Wu's
 #pragma once
 #include "Maths/Maths.h"
 #include "Framebuffer.h"
 #include <stdint.h>
+#include <cmath>
 #include <utility>
 
 namespace MiniRenderer
 {
-	/// @brief Draws a Line from the points x0, y0 to x1, y1 with the specified color in the supplied framebuffer.
-	inline void DrawLine(int x0, int y0, int x1, int y1, uint32_t color, Framebuffer& buffer)
+	/// @brief Lines are cut to this distance from the origin before they are stepped, so their steps can be counted in 64 bits.
+	const int LINE_GUARD_BAND = 1 << 24;
+
+	/// @brief Cohen & Sutherland outcode of the point: which of the left, right, bottom & top edges of the width x height area it lies beyond.
+	inline int LineOutcode(int x, int y, int width, int height)
+	{
+		return (x < 0) | ((x >= width) << 1) | ((y < 0) << 2) | ((y >= height) << 3);
+	}
+
+	/// @brief Cuts the line to the rectangle from minX, minY to maxX, maxY(Liang & Barsky). Returns false if nothing of it is left.
+	template<class T>
+	inline bool ClipLineToRectangle(T& x0, T& y0, T& x1, T& y1, T minX, T minY, T maxX, T maxY)
 	{
+		T dx = x1 - x0, dy = y1 - y0;
+		T p[4] = { -dx, dx, -dy, dy };
+		T q[4] = { x0 - minX, maxX - x0, y0 - minY, maxY - y0 };
+		T t0 = 0, t1 = 1;
+		for (int i = 0; i < 4; i++)
+		{
+			if (p[i] == 0)
+			{
+				if (q[i] < 0) return false;
+				continue;
+			}
+			T t = q[i] / p[i];
+			if (p[i] < 0) t0 = t > t0 ? t : t0;
+			else t1 = t < t1 ? t : t1;
+		}
+		if (t0 > t1) return false;
+
+		T startX = x0, startY = y0;
+		x0 = startX + t0 * dx;
+		y0 = startY + t0 * dy;
+		x1 = startX + t1 * dx;
+		y1 = startY + t1 * dy;
+		return true;
+	}
+
+	/// @brief Cuts the line to the square LINE_GUARD_BAND around the origin. Returns false if nothing of it is left.
+	inline bool ClipLineToGuardBand(int& x0, int& y0, int& x1, int& y1)
+	{
+		const double limit = LINE_GUARD_BAND;
+		double startX = x0, startY = y0, endX = x1, endY = y1;
+		if (!ClipLineToRectangle(startX, startY, endX, endY, -limit, -limit, limit, limit)) return false;
+
+		x0 = (int)std::lround(startX);
+		y0 = (int)std::lround(startY);
+		x1 = (int)std::lround(endX);
+		y1 = (int)std::lround(endY);
+		return true;
+	}
+
+	/// @brief Steps along count pixels of a line that is already ordered & clipped by DrawLine(), from (x, y) with the given Bresenham error.
+	/// Every pixel stepped has to be inside the framebuffer.
+	inline void StepLine(int x, int y, int count, int error, int dx, int derror, int yStep, bool steep, uint32_t color, Framebuffer& buffer)
+	{
+		for (int i = 0; i < count; i++, x++)
+		{
+			if (steep)
+				buffer.SetPixelColorUnchecked(y, x, color);
+			else
+				buffer.SetPixelColorUnchecked(x, y, color);
+
+			error += derror;
+			if (error > dx)
+			{
+				y += yStep;
+				error -= dx * 2;
+			}
+		}
+	}
+
+	/// @brief Draws the line from x0, y0 to x1, y1 into the width x height framebuffer. Only the steps inside the framebuffer are walked,
+	/// starting from the Bresenham state the line would have there, so the pixels drawn are exactly those of the unclipped line.
+	inline void DrawClippedLine(int x0, int y0, int x1, int y1, uint32_t color, Framebuffer& buffer, int width, int height)
+	{
+		int outcode0 = LineOutcode(x0, y0, width, height), outcode1 = LineOutcode(x1, y1, width, height);
+		if (outcode0 & outcode1) return;
+		const bool inside = (outcode0 | outcode1) == 0;
+
+		if (!inside && (Abs(x0) > LINE_GUARD_BAND || Abs(y0) > LINE_GUARD_BAND || Abs(x1) > LINE_GUARD_BAND || Abs(y1) > LINE_GUARD_BAND))
+			if (!ClipLineToGuardBand(x0, y0, x1, y1)) return;
+
 		bool steep = false;
 		if (Abs(x0 - x1) < Abs(y0 - y1))
 		{
 			std::swap(x0, y0);
 			std::swap(x1, y1);
+			std::swap(width, height);
 			steep = true;
 		}
 
@@ -23,37 +105,162 @@ namespace MiniRenderer
 			std::swap(x0, x1);
 			std::swap(y0, y1);
 		}
-		int dx = x1 - x0;
-		int dy = y1 - y0;
-		int derror = Abs(dy) * 2;
-		int error = 0;
-		int y = y0;
 
-		if (steep)
+		const int dx = x1 - x0;
+		const int dyAbs = Abs(y1 - y0);
+		const int yStep = y1 > y0 ? 1 : -1;
+		if (inside)
 		{
-			for (int x = x0; x <= x1; x++)
-			{
-				buffer.SetPixelColor(y, x, color);
-				error += derror;
-				if (error > dx)
-				{
-					y += y1 > y0 ? 1 : -1;
-					error -= dx * 2;
-				}
-			}
+			StepLine(x0, y0, dx + 1, 0, dx, dyAbs * 2, yStep, steep, color, buffer);
+			return;
+		}
+
+		// After k steps the line has moved n(k) = floor((2k|dy| + dx - 1) / 2dx) pixels along y, so the steps inside the framebuffer
+		// are a range of k found from the edges it crosses, like the range of t of Liang & Barsky.
+		int64_t first = Max(0, -x0), last = Min(dx, width - 1 - x0);
+		if (dyAbs == 0)
+		{
+			if (y0 < 0 || y0 >= height) return;
 		}
 		else
 		{
-			for (int x = x0; x <= x1; x++)
+			// Smallest k with n(k) >= n.
+			auto firstStep = [dx, dyAbs](int64_t n) -> int64_t
 			{
-				buffer.SetPixelColor(x, y, color);
-				error += derror;
-				if (error > dx)
-				{
-					y += y1 > y0 ? 1 : -1;
-					error -= dx * 2;
-				}
+				if (n <= 0) return 0;
+				int64_t numerator = 2 * (int64_t)dx * n - dx + 1, denominator = 2 * (int64_t)dyAbs;
+				return (numerator + denominator - 1) / denominator;
+			};
+			int64_t lowest = yStep > 0 ? -y0 : y0 - (height - 1);
+			int64_t highest = yStep > 0 ? (height - 1) - y0 : y0;
+			if (highest < 0) return;
+			first = Max(first, firstStep(lowest));
+			last = Min(last, firstStep(highest + 1) - 1);
+		}
+		if (first > last) return;
+
+		int64_t moved = dx > 0 ? (2 * first * dyAbs + dx - 1) / (2 * (int64_t)dx) : 0;
+		int error = (int)(2 * first * dyAbs - 2 * (int64_t)dx * moved);
+		StepLine(x0 + (int)first, y0 + yStep * (int)moved, (int)(last - first + 1), error, dx, dyAbs * 2, yStep, steep, color, buffer);
+	}
+
+	/// @brief Draws a Line from the points x0, y0 to x1, y1 with the specified color in the supplied framebuffer.
+	inline void DrawLine(int x0, int y0, int x1, int y1, uint32_t color, Framebuffer& buffer)
+	{
+		DrawClippedLine(x0, y0, x1, y1, color, buffer, buffer.GetFramebufferWidth(), buffer.GetFramebufferHeight());
+	}
+
+	/// @brief Draws lineCount lines with the specified color, line i going from points[indices[2i]] to points[indices[2i + 1]].
+	/// Lines lying entirely beyond one edge of the framebuffer are rejected 4 at a time, the rest are clipped & drawn unchecked.
+	inline void DrawLines(const Vec2i* points, const uint32_t* indices, size_t lineCount, uint32_t color, Framebuffer& buffer)
+	{
+		const int width = buffer.GetFramebufferWidth(), height = buffer.GetFramebufferHeight();
+		const __m128i minimum = _mm_set1_epi32(0), maximumX = _mm_set1_epi32(width - 1), maximumY = _mm_set1_epi32(height - 1);
+
+		size_t line = 0;
+		for (; line + 4 <= lineCount; line += 4)
+		{
+			const uint32_t* pair = indices + line * 2;
+			__m128i x0 = _mm_setr_epi32(points[pair[0]].x, points[pair[2]].x, points[pair[4]].x, points[pair[6]].x);
+			__m128i y0 = _mm_setr_epi32(points[pair[0]].y, points[pair[2]].y, points[pair[4]].y, points[pair[6]].y);
+			__m128i x1 = _mm_setr_epi32(points[pair[1]].x, points[pair[3]].x, points[pair[5]].x, points[pair[7]].x);
+			__m128i y1 = _mm_setr_epi32(points[pair[1]].y, points[pair[3]].y, points[pair[5]].y, points[pair[7]].y);
+
+			// Both end points beyond the same edge.
+			__m128i outside = _mm_and_si128(_mm_cmpgt_epi32(minimum, x0), _mm_cmpgt_epi32(minimum, x1));
+			outside = _mm_or_si128(outside, _mm_and_si128(_mm_cmpgt_epi32(minimum, y0), _mm_cmpgt_epi32(minimum, y1)));
+			outside = _mm_or_si128(outside, _mm_and_si128(_mm_cmpgt_epi32(x0, maximumX), _mm_cmpgt_epi32(x1, maximumX)));
+			outside = _mm_or_si128(outside, _mm_and_si128(_mm_cmpgt_epi32(y0, maximumY), _mm_cmpgt_epi32(y1, maximumY)));
+
+			int rejected = _mm_movemask_ps(_mm_castsi128_ps(outside));
+			if (rejected == 0xF) continue;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (rejected & (1 << lane)) continue;
+				const Vec2i& from = points[pair[lane * 2]];
+				const Vec2i& to = points[pair[lane * 2 + 1]];
+				DrawClippedLine(from.x, from.y, to.x, to.y, color, buffer, width, height);
 			}
 		}
+
+		for (; line < lineCount; line++)
+		{
+			const Vec2i& from = points[indices[line * 2]];
+			const Vec2i& to = points[indices[line * 2 + 1]];
+			DrawClippedLine(from.x, from.y, to.x, to.y, color, buffer, width, height);
+		}
+	}
+
+	/// @brief Draws an anti-aliased line from the points x0, y0 to x1, y1(pixel centers are at whole coordinates) with the specified color
+	/// in the supplied framebuffer(Xiaolin Wu). Each step along the line blends the color into the 2 pixels across it, weighted by how much
+	/// of them the 1 pixel wide line covers, so lines can be drawn over what is already in the framebuffer. alpha scales the coverage.
+	inline void DrawLineAntialiased(float x0, float y0, float x1, float y1, uint32_t color, Framebuffer& buffer, unsigned char alpha = 255)
+	{
+		const int width = buffer.GetFramebufferWidth(), height = buffer.GetFramebufferHeight();
+
+		// Keep a pixel around the framebuffer, the pixels across the line next to its edges are partly covered.
+		if (!ClipLineToRectangle(x0, y0, x1, y1, -2.0f, -2.0f, width + 1.0f, height + 1.0f)) return;
+
+		bool steep = false;
+		if (std::fabs(x0 - x1) < std::fabs(y0 - y1))
+		{
+			std::swap(x0, y0);
+			std::swap(x1, y1);
+			steep = true;
+		}
+
+		if (x0 > x1)
+		{
+			std::swap(x0, x1);
+			std::swap(y0, y1);
+		}
+
+		const float dx = x1 - x0;
+		const float gradient = dx > 0.0f ? (y1 - y0) / dx : 1.0f;
+
+		auto plot = [&](int x, int y, float coverage)
+		{
+			if (steep) std::swap(x, y);
+			unsigned char weight = (unsigned char)(coverage * alpha + 0.5f);
+			if (weight != 0 && x >= 0 && y >= 0 && x < width && y < height)
+				buffer.BlendPixelUnchecked(x, y, color, weight);
+		};
+
+		// The end points only cover the part of their pixel the line reaches into.
+		float xEnd = std::floor(x0 + 0.5f);
+		float yEnd = y0 + gradient * (xEnd - x0);
+		float xGap = 1.0f - (x0 + 0.5f - xEnd);
+		const int xFirst = (int)xEnd;
+		float yFloor = std::floor(yEnd);
+		plot(xFirst, (int)yFloor, (1.0f - (yEnd - yFloor)) * xGap);
+		plot(xFirst, (int)yFloor + 1, (yEnd - yFloor) * xGap);
+		float y = yEnd + gradient;
+
+		xEnd = std::floor(x1 + 0.5f);
+		yEnd = y1 + gradient * (xEnd - x1);
+		xGap = x1 + 0.5f - xEnd;
+		const int xLast = (int)xEnd;
+		if (xLast == xFirst) return;
+		yFloor = std::floor(yEnd);
+		plot(xLast, (int)yFloor, (1.0f - (yEnd - yFloor)) * xGap);
+		plot(xLast, (int)yFloor + 1, (yEnd - yFloor) * xGap);
+
+		for (int x = xFirst + 1; x < xLast; x++, y += gradient)
+		{
+			yFloor = std::floor(y);
+			plot(x, (int)yFloor, 1.0f - (y - yFloor));
+			plot(x, (int)yFloor + 1, y - yFloor);
+		}
+	}
+
+	/// @brief Draws lineCount anti-aliased lines with the specified color, line i going from points[indices[2i]] to points[indices[2i + 1]].
+	inline void DrawLinesAntialiased(const Vec2f* points, const uint32_t* indices, size_t lineCount, uint32_t color, Framebuffer& buffer, unsigned char alpha = 255)
+	{
+		for (size_t line = 0; line < lineCount; line++)
+		{
+			const Vec2f& from = points[indices[line * 2]];
+			const Vec2f& to = points[indices[line * 2 + 1]];
+			DrawLineAntialiased(from.x, from.y, to.x, to.y, color, buffer, alpha);
+		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,495 @@
+#include "GltfLoader.h"
+#include "Json.h"
+#include "../MappedFile.h"
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+namespace MiniRenderer
+{
+	static const uint32_t GLB_MAGIC = 0x46546C67;		// "glTF"
+	static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;	// "JSON"
+	static const uint32_t GLB_CHUNK_BIN = 0x004E4942;	// "BIN\0"
+
+	// Accessor component types.
+	static const int GLTF_BYTE = 5120;
+	static const int GLTF_UNSIGNED_BYTE = 5121;
+	static const int GLTF_SHORT = 5122;
+	static const int GLTF_UNSIGNED_SHORT = 5123;
+	static const int GLTF_UNSIGNED_INT = 5125;
+	static const int GLTF_FLOAT = 5126;
+
+	static const int GLTF_TRIANGLES = 4;
+
+	/// @brief Largest byteStride of a buffer view allowed by the glTF 2.0 specification.
+	static const size_t MAX_BYTE_STRIDE = 252;
+
+	/// @brief Column major 4x4 matrix, as glTF stores them.
+	struct GltfMatrix
+	{
+		float m[16];
+
+		static GltfMatrix Identity()
+		{
+			GltfMatrix result = {};
+			result.m[0] = result.m[5] = result.m[10] = result.m[15] = 1.0f;
+			return result;
+		}
+
+		GltfMatrix operator *(const GltfMatrix& other) const
+		{
+			GltfMatrix result = {};
+			for (int column = 0; column < 4; column++)
+				for (int row = 0; row < 4; row++)
+					for (int k = 0; k < 4; k++)
+						result.m[column * 4 + row] += m[k * 4 + row] * other.m[column * 4 + k];
+			return result;
+		}
+	};
+
+	/// @brief Contents of a buffer, either viewed in a mapped file or decoded from a data URI.
+	struct GltfBuffer
+	{
+		std::shared_ptr<const MappedFile> file;
+		std::vector<char> bytes;
+		const char* data = nullptr;
+		size_t size = 0;
+	};
+
+	/// @brief Elements of an accessor, resolved down to where they are in their buffer.
+	struct GltfAccessor
+	{
+		const GltfBuffer* buffer = nullptr;
+		const char* data = nullptr;
+		size_t count = 0;
+		size_t stride = 0;
+		int componentType = 0;
+		int components = 0;
+		bool normalized = false;
+	};
+
+	static size_t ComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: return 1;
+		case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+		case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+		default: throw std::runtime_error("Unsupported glTF accessor component type.\n");
+		}
+	}
+
+	static int ComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		throw std::runtime_error("Unsupported glTF accessor type " + type + ".\n");
+	}
+
+	/// @brief Reads one component as a float, applying the normalization of integer components.
+	static inline float ReadComponent(const char* p, int componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case GLTF_FLOAT: { float v; std::memcpy(&v, p, 4); return v; }
+		case GLTF_BYTE: { int8_t v = (int8_t)*p; return normalized ? std::fmax(v / 127.0f, -1.0f) : (float)v; }
+		case GLTF_UNSIGNED_BYTE: { uint8_t v = (uint8_t)*p; return normalized ? v / 255.0f : (float)v; }
+		case GLTF_SHORT: { int16_t v; std::memcpy(&v, p, 2); return normalized ? std::fmax(v / 32767.0f, -1.0f) : (float)v; }
+		case GLTF_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p, 2); return normalized ? v / 65535.0f : (float)v; }
+		default: { uint32_t v; std::memcpy(&v, p, 4); return (float)v; }
+		}
+	}
+
+	/// @brief Reads one component as an unsigned integer index.
+	static inline uint32_t ReadIndex(const char* p, int componentType)
+	{
+		switch (componentType)
+		{
+		case GLTF_UNSIGNED_BYTE: return (uint8_t)*p;
+		case GLTF_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p, 2); return v; }
+		default: { uint32_t v; std::memcpy(&v, p, 4); return v; }
+		}
+	}
+
+	/// @brief Returns the JSON number as a size, 0 if it is missing. Throws if it is negative, not whole or larger than limit,
+	/// so sizes & offsets taken from the file can't overflow the bounds checks done with them.
+	static size_t ReadSize(const JsonValue& value, size_t limit, const char* name)
+	{
+		double number = value.AsNumber();
+		if (!(number >= 0.0) || number != std::floor(number) || number > (double)limit)
+			throw std::runtime_error(std::string("glTF ") + name + " is not a valid size.\n");
+		return (size_t)number;
+	}
+
+	/// @brief Decodes base64 text, skipping characters outside the alphabet.
+	static std::vector<char> DecodeBase64(const char* text, size_t length)
+	{
+		std::vector<char> bytes;
+		bytes.reserve(length / 4 * 3);
+
+		uint32_t bits = 0;
+		int bitCount = 0;
+		for (size_t i = 0; i < length; i++)
+		{
+			char c = text[i];
+			int value;
+			if (c >= 'A' && c <= 'Z') value = c - 'A';
+			else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+			else if (c >= '0' && c <= '9') value = c - '0' + 52;
+			else if (c == '+' || c == '-') value = 62;
+			else if (c == '/' || c == '_') value = 63;
+			else continue;
+
+			bits = (bits << 6) | (uint32_t)value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				bytes.push_back((char)((bits >> bitCount) & 0xFF));
+			}
+		}
+		return bytes;
+	}
+
+	/// @brief Returns the folder of path, with a trailing separator.
+	static std::string Directory(const std::string& path)
+	{
+		size_t separator = path.find_last_of("/\\");
+		return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+	}
+
+	/// @brief Loads every buffer of the document, binChunk being the BIN chunk of a .glb file or nullptr.
+	static std::vector<GltfBuffer> LoadBuffers(const JsonValue& document, const std::string& path,
+											   const std::shared_ptr<const MappedFile>& file, const char* binChunk, size_t binSize)
+	{
+		const JsonValue& buffers = document["buffers"];
+		std::vector<GltfBuffer> result(buffers.Size());
+		for (size_t i = 0; i < result.size(); i++)
+		{
+			const JsonValue& uri = buffers[i]["uri"];
+			GltfBuffer& buffer = result[i];
+			if (!uri.IsString())
+			{
+				// The first buffer of a .glb file without an uri is its BIN chunk.
+				if (i != 0 || binChunk == nullptr)
+					throw std::runtime_error("glTF buffer " + std::to_string(i) + " has no data.\n");
+				buffer.file = file;
+				buffer.data = binChunk;
+				buffer.size = binSize;
+			}
+			else if (uri.AsString().compare(0, 5, "data:") == 0)
+			{
+				size_t comma = uri.AsString().find(',');
+				if (comma == std::string::npos || uri.AsString().rfind(";base64", comma) == std::string::npos)
+					throw std::runtime_error("Only base64 data URIs are supported in glTF buffers.\n");
+				buffer.bytes = DecodeBase64(uri.AsString().data() + comma + 1, uri.AsString().size() - comma - 1);
+				buffer.data = buffer.bytes.data();
+				buffer.size = buffer.bytes.size();
+			}
+			else
+			{
+				buffer.file = std::make_shared<const MappedFile>(Directory(path) + uri.AsString());
+				buffer.data = buffer.file->Data();
+				buffer.size = buffer.file->Size();
+			}
+
+			if (!(buffers[i]["byteLength"].AsNumber() <= (double)buffer.size))
+				throw std::runtime_error("glTF buffer " + std::to_string(i) + " is shorter than its byteLength.\n");
+		}
+		return result;
+	}
+
+	/// @brief Resolves the accessor at index & checks that all its elements lie inside their buffer.
+	static GltfAccessor GetAccessor(const JsonValue& document, const std::vector<GltfBuffer>& buffers, int index)
+	{
+		const JsonValue& accessor = document["accessors"][(size_t)index];
+		if (!accessor.IsObject())
+			throw std::runtime_error("glTF accessor " + std::to_string(index) + " doesn't exist.\n");
+		if (!accessor["sparse"].IsNull())
+			throw std::runtime_error("Sparse glTF accessors are not supported.\n");
+
+		GltfAccessor result;
+		result.componentType = accessor["componentType"].AsInt();
+		result.components = ComponentCount(accessor["type"].AsString());
+		result.normalized = accessor["normalized"].AsBool();
+		size_t elementSize = ComponentSize(result.componentType) * result.components;
+
+		const JsonValue& view = document["bufferViews"][(size_t)accessor["bufferView"].AsInt(-1)];
+		if (!view.IsObject())
+			throw std::runtime_error("glTF accessor " + std::to_string(index) + " has no buffer view.\n");
+
+		size_t bufferIndex = (size_t)view["buffer"].AsInt(-1);
+		if (bufferIndex >= buffers.size())
+			throw std::runtime_error("glTF buffer view uses a buffer that doesn't exist.\n");
+		result.buffer = &buffers[bufferIndex];
+
+		// Every size is checked against what contains it before it is used, so none of the checks can wrap around.
+		const size_t bufferSize = result.buffer->size;
+		size_t viewLength = ReadSize(view["byteLength"], bufferSize, "buffer view byteLength");
+		size_t viewOffset = ReadSize(view["byteOffset"], bufferSize - viewLength, "buffer view byteOffset");
+		size_t offset = ReadSize(accessor["byteOffset"], viewLength, "accessor byteOffset");
+		result.count = ReadSize(accessor["count"], viewLength, "accessor count");
+		result.stride = view["byteStride"].IsNumber() ? ReadSize(view["byteStride"], MAX_BYTE_STRIDE, "buffer view byteStride") : elementSize;
+		if (result.stride < elementSize)
+			throw std::runtime_error("glTF accessor " + std::to_string(index) + " has elements larger than its byteStride.\n");
+
+		if (result.count > 0 && (elementSize > viewLength - offset || result.count - 1 > (viewLength - offset - elementSize) / result.stride))
+			throw std::runtime_error("glTF accessor " + std::to_string(index) + " lies outside its buffer.\n");
+
+		result.data = result.buffer->data + viewOffset + offset;
+		return result;
+	}
+
+	/// @brief Reads the VEC3 accessor, transforming every element by matrix(w being 1 for points, 0 for directions).
+	/// Positions & normals can't be viewed in place like indices & texture coordinates: glTF packs them in 12 bytes where a Vec3f
+	/// takes 16, & the world transform of their node is baked into them as a Mesh has no transform of its own.
+	static std::vector<Vec3f> ReadVec3(const GltfAccessor& accessor, const float matrix[12], float w)
+	{
+		if (accessor.components != 3)
+			throw std::runtime_error("glTF positions & normals have to be VEC3.\n");
+
+		std::vector<Vec3f> result(accessor.count);
+		for (size_t i = 0; i < accessor.count; i++)
+		{
+			const char* p = accessor.data + i * accessor.stride;
+			float v[3];
+			if (accessor.componentType == GLTF_FLOAT)
+				std::memcpy(v, p, sizeof(v));
+			else
+			{
+				size_t size = ComponentSize(accessor.componentType);
+				for (int k = 0; k < 3; k++) v[k] = ReadComponent(p + k * size, accessor.componentType, accessor.normalized);
+			}
+
+			result[i] = Vec3f(matrix[0] * v[0] + matrix[3] * v[1] + matrix[6] * v[2] + matrix[9] * w,
+							  matrix[1] * v[0] + matrix[4] * v[1] + matrix[7] * v[2] + matrix[10] * w,
+							  matrix[2] * v[0] + matrix[5] * v[1] + matrix[8] * v[2] + matrix[11] * w);
+		}
+		return result;
+	}
+
+	/// @brief Builds the Mesh of one triangle primitive with the world transform of its node baked in.
+	static void LoadPrimitive(const JsonValue& document, const std::vector<GltfBuffer>& buffers, const JsonValue& primitive, const GltfMatrix& world, Mesh& mesh)
+	{
+		const JsonValue& attributes = primitive["attributes"];
+		if (!attributes["POSITION"].IsNumber())
+			throw std::runtime_error("glTF primitive has no POSITION attribute.\n");
+
+		// Upper 3x3 & translation of the world matrix for positions, the cofactor of the 3x3 for normals.
+		const float* m = world.m;
+		float pointMatrix[12] = { m[0], m[1], m[2], m[4], m[5], m[6], m[8], m[9], m[10], m[12], m[13], m[14] };
+		float normalMatrix[12] = { m[5] * m[10] - m[6] * m[9], m[6] * m[8] - m[4] * m[10], m[4] * m[9] - m[5] * m[8],
+								   m[9] * m[2] - m[10] * m[1], m[10] * m[0] - m[8] * m[2], m[8] * m[1] - m[9] * m[0],
+								   m[1] * m[6] - m[2] * m[5], m[2] * m[4] - m[0] * m[6], m[0] * m[5] - m[1] * m[4], 0.0f, 0.0f, 0.0f };
+		float determinant = m[0] * normalMatrix[0] + m[1] * normalMatrix[1] + m[2] * normalMatrix[2];
+
+		GltfAccessor positions = GetAccessor(document, buffers, attributes["POSITION"].AsInt());
+		mesh.vertices = ReadVec3(positions, pointMatrix, 1.0f);
+
+		if (attributes["NORMAL"].IsNumber())
+		{
+			std::vector<Vec3f> normals = ReadVec3(GetAccessor(document, buffers, attributes["NORMAL"].AsInt()), normalMatrix, 0.0f);
+			if (normals.size() != positions.count)
+				throw std::runtime_error("glTF primitive has a different number of normals than positions.\n");
+			for (Vec3f& normal : normals)
+			{
+				float length = normal.length();
+				if (length > 0.0f) normal = Vec3f(normal.x / length, normal.y / length, normal.z / length);
+			}
+			mesh.normals = std::move(normals);
+		}
+
+		if (attributes["TEXCOORD_0"].IsNumber())
+		{
+			GltfAccessor texcoords = GetAccessor(document, buffers, attributes["TEXCOORD_0"].AsInt());
+			if (texcoords.components != 2 || texcoords.count != positions.count)
+				throw std::runtime_error("glTF TEXCOORD_0 has to be one VEC2 per position.\n");
+
+			if (texcoords.componentType == GLTF_FLOAT && texcoords.stride == sizeof(Vec2f) && ((uintptr_t)texcoords.data & (alignof(Vec2f) - 1)) == 0 && texcoords.buffer->file)
+			{
+				// Tightly packed float pairs have the layout of Vec2f & are never transformed, so they are used in place in the mapped file.
+				mesh.texcoords = MeshBuffer<Vec2f>(texcoords.buffer->file, reinterpret_cast<const Vec2f*>(texcoords.data), texcoords.count);
+			}
+			else
+			{
+				std::vector<Vec2f> values(texcoords.count);
+				size_t size = ComponentSize(texcoords.componentType);
+				for (size_t i = 0; i < texcoords.count; i++)
+				{
+					const char* p = texcoords.data + i * texcoords.stride;
+					values[i] = Vec2f(ReadComponent(p, texcoords.componentType, texcoords.normalized), ReadComponent(p + size, texcoords.componentType, texcoords.normalized));
+				}
+				mesh.texcoords = std::move(values);
+			}
+		}
+
+		// glTF triangles are counter clockwise, unless a mirroring transform flips them.
+		mesh.counterClockwise = determinant >= 0.0f;
+		if (primitive["indices"].IsNumber())
+		{
+			GltfAccessor indices = GetAccessor(document, buffers, primitive["indices"].AsInt());
+			if (indices.components != 1 || (indices.componentType != GLTF_UNSIGNED_BYTE && indices.componentType != GLTF_UNSIGNED_SHORT && indices.componentType != GLTF_UNSIGNED_INT))
+				throw std::runtime_error("glTF indices have to be unsigned integer scalars.\n");
+
+			const size_t triangleIndices = indices.count / 3 * 3;
+			for (size_t i = 0; i < triangleIndices; i++)
+				if (ReadIndex(indices.data + i * indices.stride, indices.componentType) >= positions.count)
+					throw std::runtime_error("glTF indices reference vertices that don't exist.\n");
+
+			if (indices.componentType == GLTF_UNSIGNED_INT && indices.stride == 4 && ((uintptr_t)indices.data & 3) == 0 && indices.buffer->file)
+			{
+				// Tightly packed 32 bit indices are used in place in the mapped file.
+				mesh.faces = MeshBuffer<unsigned int>(indices.buffer->file, reinterpret_cast<const unsigned int*>(indices.data), triangleIndices);
+			}
+			else
+			{
+				std::vector<unsigned int> faces(triangleIndices);
+				for (size_t i = 0; i < triangleIndices; i++)
+					faces[i] = ReadIndex(indices.data + i * indices.stride, indices.componentType);
+				mesh.faces = std::move(faces);
+			}
+		}
+		else
+		{
+			std::vector<unsigned int> faces(positions.count / 3 * 3);
+			for (size_t i = 0; i < faces.size(); i++)
+				faces[i] = (unsigned int)i;
+			mesh.faces = std::move(faces);
+		}
+
+		mesh.nVertices = (uint32_t)mesh.vertices.size();
+		mesh.nFaces = (uint32_t)mesh.faces.size();
+	}
+
+	/// @brief Returns the element at index of the JSON array as a float, fallback if it is missing.
+	static inline float ArrayFloat(const JsonValue& array, size_t index, float fallback = 0.0f)
+	{
+		return (float)array[index].AsNumber(fallback);
+	}
+
+	/// @brief Returns the local transform of the node, from its matrix or its translation, rotation & scale.
+	static GltfMatrix LocalTransform(const JsonValue& node)
+	{
+		GltfMatrix result = GltfMatrix::Identity();
+		const JsonValue& matrix = node["matrix"];
+		if (matrix.Size() == 16)
+		{
+			for (size_t i = 0; i < 16; i++) result.m[i] = (float)matrix[i].AsNumber();
+			return result;
+		}
+
+		const JsonValue& t = node["translation"];
+		const JsonValue& r = node["rotation"];
+		const JsonValue& s = node["scale"];
+		float x = ArrayFloat(r, 0, 0.0f), y = ArrayFloat(r, 1, 0.0f), z = ArrayFloat(r, 2, 0.0f), w = ArrayFloat(r, 3, 1.0f);
+		float sx = ArrayFloat(s, 0, 1.0f), sy = ArrayFloat(s, 1, 1.0f), sz = ArrayFloat(s, 2, 1.0f);
+
+		// T * R * S, with R from the unit quaternion (x, y, z, w).
+		result.m[0] = (1 - 2 * (y * y + z * z)) * sx;	result.m[4] = 2 * (x * y - z * w) * sy;			result.m[8] = 2 * (x * z + y * w) * sz;
+		result.m[1] = 2 * (x * y + z * w) * sx;			result.m[5] = (1 - 2 * (x * x + z * z)) * sy;	result.m[9] = 2 * (y * z - x * w) * sz;
+		result.m[2] = 2 * (x * z - y * w) * sx;			result.m[6] = 2 * (y * z + x * w) * sy;			result.m[10] = (1 - 2 * (x * x + y * y)) * sz;
+		result.m[12] = ArrayFloat(t, 0);
+		result.m[13] = ArrayFloat(t, 1);
+		result.m[14] = ArrayFloat(t, 2);
+		return result;
+	}
+
+	/// @brief Appends the meshes of the node & its children, depth being used to reject cyclic hierarchies.
+	static void LoadNode(const JsonValue& document, const std::vector<GltfBuffer>& buffers, size_t nodeIndex, const GltfMatrix& parent,
+						 std::vector<Mesh>& meshes, size_t depth)
+	{
+		const JsonValue& nodes = document["nodes"];
+		if (nodeIndex >= nodes.Size() || depth > nodes.Size())
+			throw std::runtime_error("glTF node hierarchy is invalid.\n");
+
+		const JsonValue& node = nodes[nodeIndex];
+		GltfMatrix world = parent * LocalTransform(node);
+
+		if (node["mesh"].IsNumber())
+		{
+			const JsonValue& primitives = document["meshes"][(size_t)node["mesh"].AsInt()]["primitives"];
+			for (size_t i = 0; i < primitives.Size(); i++)
+			{
+				if (primitives[i]["mode"].AsInt(GLTF_TRIANGLES) != GLTF_TRIANGLES) continue;
+				meshes.emplace_back();
+				LoadPrimitive(document, buffers, primitives[i], world, meshes.back());
+			}
+		}
+
+		const JsonValue& children = node["children"];
+		for (size_t i = 0; i < children.Size(); i++)
+			LoadNode(document, buffers, (size_t)children[i].AsInt(-1), world, meshes, depth + 1);
+	}
+
+	void LoadGltf(const std::string& path, std::vector<Mesh>& meshes)
+	{
+		std::shared_ptr<const MappedFile> file = std::make_shared<const MappedFile>(path);
+		const char* json = file->Data();
+		size_t jsonSize = file->Size();
+		const char* binChunk = nullptr;
+		size_t binSize = 0;
+
+		uint32_t header[3];
+		if (file->Size() >= sizeof(header))
+			std::memcpy(header, file->Data(), sizeof(header));
+		if (file->Size() >= sizeof(header) && header[0] == GLB_MAGIC)
+		{
+			// Binary glTF: a header, then a JSON chunk & an optional BIN chunk.
+			if (header[1] != 2 || header[2] > file->Size())
+				throw std::runtime_error("Unsupported or truncated glb file " + path + ".\n");
+
+			json = nullptr;
+			for (size_t offset = sizeof(header); offset + 8 <= header[2];)
+			{
+				uint32_t chunk[2];
+				std::memcpy(chunk, file->Data() + offset, sizeof(chunk));
+				if (chunk[0] > header[2] - offset - 8)
+					throw std::runtime_error("Truncated chunk in glb file " + path + ".\n");
+
+				const char* data = file->Data() + offset + 8;
+				if (chunk[1] == GLB_CHUNK_JSON && json == nullptr) { json = data; jsonSize = chunk[0]; }
+				else if (chunk[1] == GLB_CHUNK_BIN && binChunk == nullptr) { binChunk = data; binSize = chunk[0]; }
+				offset += 8 + ((chunk[0] + 3) & ~3u);
+			}
+			if (json == nullptr)
+				throw std::runtime_error("glb file " + path + " has no JSON chunk.\n");
+		}
+
+		JsonValue document = ParseJson(json, json + jsonSize);
+		if (document["asset"]["version"].AsString().compare(0, 2, "2.") != 0)
+			throw std::runtime_error("Only glTF 2.0 files are supported, " + path + " is not one.\n");
+
+		std::vector<GltfBuffer> buffers = LoadBuffers(document, path, file, binChunk, binSize);
+
+		// Nodes of the default scene, or every root node if there are no scenes.
+		std::vector<size_t> roots;
+		const JsonValue& scenes = document["scenes"];
+		if (scenes.Size() > 0)
+		{
+			const JsonValue& sceneNodes = scenes[(size_t)document["scene"].AsInt(0)]["nodes"];
+			for (size_t i = 0; i < sceneNodes.Size(); i++) roots.push_back((size_t)sceneNodes[i].AsInt(-1));
+		}
+		else
+		{
+			const JsonValue& nodes = document["nodes"];
+			std::vector<bool> isChild(nodes.Size(), false);
+			for (size_t i = 0; i < nodes.Size(); i++)
+				for (size_t c = 0; c < nodes[i]["children"].Size(); c++)
+				{
+					size_t child = (size_t)nodes[i]["children"][c].AsInt(-1);
+					if (child < isChild.size()) isChild[child] = true;
+				}
+			for (size_t i = 0; i < nodes.Size(); i++)
+				if (!isChild[i]) roots.push_back(i);
+		}
+
+		std::vector<Mesh> loaded;
+		for (size_t root : roots)
+			LoadNode(document, buffers, root, GltfMatrix::Identity(), loaded, 0);
+
+		meshes.insert(meshes.end(), std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+	}
+}
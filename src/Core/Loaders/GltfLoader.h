@@ -0,0 +1,15 @@
+// Loads glTF 2.0 files.
+#pragma once
+
+#include "../Model.h"
+#include <string>
+#include <vector>
+
+namespace MiniRenderer
+{
+	/// @brief Loads the glTF 2.0 file(.gltf with external or embedded buffers, or binary .glb) at path & appends its meshes to meshes.
+	/// Every triangle primitive of every mesh node of the default scene becomes a Mesh, with the node's world transform baked in.
+	/// Tightly packed 32 bit indices & float texture coordinates of mapped buffers are used in place, positions & normals are always copied:
+	/// they are 12 bytes in glTF & 16 in a Vec3f, & each node referencing a mesh gets its own transformed copy.
+	void LoadGltf(const std::string& path, std::vector<Mesh>& meshes);
+}
@@ -0,0 +1,220 @@
+#include "Json.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace MiniRenderer
+{
+	/// @brief Shared value returned by lookups that find nothing.
+	static const JsonValue NULL_JSON_VALUE;
+
+	/// @brief Nesting deeper than this is rejected instead of overflowing the stack.
+	static const int MAX_JSON_DEPTH = 256;
+
+	const JsonValue& JsonValue::operator [](const char* key) const
+	{
+		if (type == Type::Object)
+		{
+			for (const std::pair<std::string, JsonValue>& member : object)
+				if (member.first == key) return member.second;
+		}
+		return NULL_JSON_VALUE;
+	}
+
+	const JsonValue& JsonValue::operator [](size_t index) const
+	{
+		return type == Type::Array && index < array.size() ? array[index] : NULL_JSON_VALUE;
+	}
+
+	/// @brief Recursive descent parser over the text of one document.
+	class JsonParser
+	{
+	public:
+		JsonParser(const char* begin, const char* end) : m_Current(begin), m_End(end) {}
+
+		JsonValue ParseDocument()
+		{
+			JsonValue value;
+			ParseValue(value, 0);
+			SkipSpaces();
+			if (m_Current != m_End) Fail("unexpected characters after the document");
+			return value;
+		}
+	private:
+		[[noreturn]] void Fail(const char* reason)
+		{
+			throw std::runtime_error(std::string("Invalid JSON: ") + reason + ".\n");
+		}
+
+		void SkipSpaces()
+		{
+			while (m_Current < m_End && (*m_Current == ' ' || *m_Current == '\t' || *m_Current == '\n' || *m_Current == '\r'))
+				m_Current++;
+		}
+
+		bool Consume(const char* literal)
+		{
+			size_t length = std::strlen(literal);
+			if ((size_t)(m_End - m_Current) < length || std::memcmp(m_Current, literal, length) != 0) return false;
+			m_Current += length;
+			return true;
+		}
+
+		void ParseValue(JsonValue& value, int depth)
+		{
+			if (depth > MAX_JSON_DEPTH) Fail("nested too deeply");
+
+			SkipSpaces();
+			if (m_Current == m_End) Fail("unexpected end");
+
+			switch (*m_Current)
+			{
+			case '{': ParseObject(value, depth); break;
+			case '[': ParseArray(value, depth); break;
+			case '"': value.type = JsonValue::Type::String; ParseString(value.string); break;
+			case 't': if (!Consume("true")) Fail("unknown literal"); value.type = JsonValue::Type::Bool; value.boolean = true; break;
+			case 'f': if (!Consume("false")) Fail("unknown literal"); value.type = JsonValue::Type::Bool; value.boolean = false; break;
+			case 'n': if (!Consume("null")) Fail("unknown literal"); value.type = JsonValue::Type::Null; break;
+			default: ParseNumber(value); break;
+			}
+		}
+
+		void ParseObject(JsonValue& value, int depth)
+		{
+			value.type = JsonValue::Type::Object;
+			m_Current++;	// {
+			SkipSpaces();
+			if (m_Current < m_End && *m_Current == '}') { m_Current++; return; }
+
+			while (true)
+			{
+				SkipSpaces();
+				if (m_Current == m_End || *m_Current != '"') Fail("expected a member name");
+				value.object.emplace_back();
+				ParseString(value.object.back().first);
+
+				SkipSpaces();
+				if (m_Current == m_End || *m_Current != ':') Fail("expected ':'");
+				m_Current++;
+				ParseValue(value.object.back().second, depth + 1);
+
+				SkipSpaces();
+				if (m_Current == m_End) Fail("unexpected end in object");
+				if (*m_Current == '}') { m_Current++; return; }
+				if (*m_Current != ',') Fail("expected ',' or '}'");
+				m_Current++;
+			}
+		}
+
+		void ParseArray(JsonValue& value, int depth)
+		{
+			value.type = JsonValue::Type::Array;
+			m_Current++;	// [
+			SkipSpaces();
+			if (m_Current < m_End && *m_Current == ']') { m_Current++; return; }
+
+			while (true)
+			{
+				value.array.emplace_back();
+				ParseValue(value.array.back(), depth + 1);
+
+				SkipSpaces();
+				if (m_Current == m_End) Fail("unexpected end in array");
+				if (*m_Current == ']') { m_Current++; return; }
+				if (*m_Current != ',') Fail("expected ',' or ']'");
+				m_Current++;
+			}
+		}
+
+		unsigned int ParseHex4()
+		{
+			if (m_End - m_Current < 4) Fail("short unicode escape");
+			unsigned int code = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				char c = *m_Current++;
+				code <<= 4;
+				if (c >= '0' && c <= '9') code |= c - '0';
+				else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+				else Fail("invalid unicode escape");
+			}
+			return code;
+		}
+
+		static void AppendUtf8(std::string& out, unsigned int code)
+		{
+			if (code < 0x80) out += (char)code;
+			else if (code < 0x800) { out += (char)(0xC0 | (code >> 6)); out += (char)(0x80 | (code & 0x3F)); }
+			else if (code < 0x10000) { out += (char)(0xE0 | (code >> 12)); out += (char)(0x80 | ((code >> 6) & 0x3F)); out += (char)(0x80 | (code & 0x3F)); }
+			else { out += (char)(0xF0 | (code >> 18)); out += (char)(0x80 | ((code >> 12) & 0x3F)); out += (char)(0x80 | ((code >> 6) & 0x3F)); out += (char)(0x80 | (code & 0x3F)); }
+		}
+
+		void ParseString(std::string& out)
+		{
+			m_Current++;	// "
+			while (true)
+			{
+				// Copy plain characters in one go.
+				const char* start = m_Current;
+				while (m_Current < m_End && *m_Current != '"' && *m_Current != '\\') m_Current++;
+				out.append(start, m_Current);
+
+				if (m_Current == m_End) Fail("unterminated string");
+				if (*m_Current++ == '"') return;
+
+				if (m_Current == m_End) Fail("unterminated escape");
+				char escape = *m_Current++;
+				switch (escape)
+				{
+				case '"': out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '/': out += '/'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u':
+				{
+					unsigned int code = ParseHex4();
+					if (code >= 0xD800 && code < 0xDC00 && Consume("\\u"))
+					{
+						unsigned int low = ParseHex4();
+						if (low >= 0xDC00 && low < 0xE000)
+							code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+					}
+					AppendUtf8(out, code);
+					break;
+				}
+				default: Fail("invalid escape");
+				}
+			}
+		}
+
+		void ParseNumber(JsonValue& value)
+		{
+			// strtod needs a terminated string, numbers are short so copy them out.
+			const char* start = m_Current;
+			while (m_Current < m_End && (std::strchr("+-0123456789.eE", *m_Current) != nullptr)) m_Current++;
+			if (m_Current == start || m_Current - start > 64) Fail("invalid number");
+
+			char text[65];
+			std::memcpy(text, start, m_Current - start);
+			text[m_Current - start] = '\0';
+
+			char* parsedEnd;
+			value.type = JsonValue::Type::Number;
+			value.number = std::strtod(text, &parsedEnd);
+			if (parsedEnd != text + (m_Current - start)) Fail("invalid number");
+		}
+	private:
+		const char* m_Current;
+		const char* m_End;
+	};
+
+	JsonValue ParseJson(const char* begin, const char* end)
+	{
+		return JsonParser(begin, end).ParseDocument();
+	}
+}
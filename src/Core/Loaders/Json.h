@@ -0,0 +1,47 @@
+// Minimal JSON document parser.
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace MiniRenderer
+{
+	/// @brief A parsed JSON value. Missing members & out of range elements read as a null value, so lookups can be chained.
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<JsonValue> array;
+		std::vector<std::pair<std::string, JsonValue>> object;
+
+		bool IsNull() const { return type == Type::Null; }
+		bool IsNumber() const { return type == Type::Number; }
+		bool IsString() const { return type == Type::String; }
+		bool IsArray() const { return type == Type::Array; }
+		bool IsObject() const { return type == Type::Object; }
+
+		/// @brief Returns the member with the key, a null value if this isn't an object or has no such member.
+		const JsonValue& operator [](const char* key) const;
+
+		/// @brief Returns the element at index, a null value if this isn't an array or is too short.
+		const JsonValue& operator [](size_t index) const;
+
+		/// @brief Number of elements of an array or members of an object.
+		size_t Size() const { return type == Type::Array ? array.size() : (type == Type::Object ? object.size() : 0); }
+
+		double AsNumber(double fallback = 0.0) const { return type == Type::Number ? number : fallback; }
+		/// @brief Returns the number truncated to an int, fallback if it isn't a number or doesn't fit in one.
+		int AsInt(int fallback = 0) const { return type == Type::Number && number > -2147483649.0 && number < 2147483648.0 ? (int)number : fallback; }
+		bool AsBool(bool fallback = false) const { return type == Type::Bool ? boolean : fallback; }
+		const std::string& AsString() const { return string; }
+	};
+
+	/// @brief Parses the JSON text in [begin, end), throws if it isn't valid JSON.
+	JsonValue ParseJson(const char* begin, const char* end);
+}
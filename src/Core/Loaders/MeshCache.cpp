@@ -0,0 +1,300 @@
+#include "MeshCache.h"
+#include "../MappedFile.h"
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+
+#ifdef PLATFORM_WINDOWS
+	#include <Windows.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+namespace MiniRenderer
+{
+	// Layout of a cache file, all values are little endian:
+	//   MeshCacheHeader
+	//   MeshCacheEntry[meshCount]
+	//   Data blocks, each starting at a multiple of MESH_CACHE_ALIGNMENT.
+	// The blocks store the arrays exactly as they are in memory, so they are used in place without copies.
+
+	static const uint32_t MESH_CACHE_MAGIC = 0x4853454D;	// "MESH"
+	static const uint32_t MESH_CACHE_VERSION = 8;
+	static const size_t MESH_CACHE_ALIGNMENT = 64;
+
+	/// @brief Arrays stored for every mesh, new ones are added at the end together with a new version.
+	enum MeshCacheStream : uint32_t
+	{
+		MESH_CACHE_POSITIONS = 0,
+		MESH_CACHE_INDICES,
+		MESH_CACHE_TEXCOORDS,
+		MESH_CACHE_NORMALS,
+		MESH_CACHE_FACE_NORMALS_X,
+		MESH_CACHE_FACE_NORMALS_Y,
+		MESH_CACHE_FACE_NORMALS_Z,
+		MESH_CACHE_QUANTIZED_POSITIONS,
+		MESH_CACHE_OCT_NORMALS,
+		MESH_CACHE_HALF_TEXCOORDS,
+		MESH_CACHE_CLUSTERS,
+		MESH_CACHE_CLUSTER_VERTICES,
+		MESH_CACHE_CLUSTER_INDICES,
+		MESH_CACHE_LODS,
+		MESH_CACHE_STREAM_COUNT
+	};
+
+	struct MeshCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t meshCount;
+		uint32_t streamCount;
+		uint64_t sourceSize;	// Size of the model file the cache was made from.
+		uint64_t sourceTime;	// Last write time of the model file the cache was made from.
+		uint64_t fileSize;		// Size of the whole cache file.
+		uint64_t checksum;		// Checksum of everything after the header.
+	};
+
+	struct MeshCacheEntry
+	{
+		struct Block
+		{
+			uint64_t offset;	// From the start of the file.
+			uint64_t count;		// Number of elements.
+		};
+		Block streams[MESH_CACHE_STREAM_COUNT];
+		float quantizationOffset[3];
+		float quantizationScale[3];
+		float boxMin[3], boxMax[3];
+		float sphere[4];	// Center & radius.
+	};
+
+	/// @brief Gets the size & last write time of the file at path, returns false if it doesn't exist.
+	static bool GetFileStamp(const std::string& path, uint64_t& size, uint64_t& time)
+	{
+#ifdef PLATFORM_WINDOWS
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes)) return false;
+		size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+		time = ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+		struct stat status;
+		if (stat(path.c_str(), &status) != 0) return false;
+		size = (uint64_t)status.st_size;
+		time = (uint64_t)status.st_mtim.tv_sec * 1000000000ull + (uint64_t)status.st_mtim.tv_nsec;
+#endif
+		return true;
+	}
+
+	/// @brief 64 bit checksum of size bytes at data, hashing 4 independent lanes so that it runs at memory speed.
+	static uint64_t Checksum(const char* data, size_t size)
+	{
+		const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+		uint64_t lanes[4] = { 1, 2, 3, 4 };
+
+		size_t i = 0;
+		for (; i + 32 <= size; i += 32)
+		{
+			for (int lane = 0; lane < 4; lane++)
+			{
+				uint64_t word;
+				std::memcpy(&word, data + i + lane * 8, 8);
+				lanes[lane] = (lanes[lane] ^ word) * PRIME;
+				lanes[lane] ^= lanes[lane] >> 29;
+			}
+		}
+
+		uint64_t hash = size;
+		for (int lane = 0; lane < 4; lane++)
+			hash = (hash ^ lanes[lane]) * PRIME;
+		for (; i < size; i++)
+			hash = (hash ^ (unsigned char)data[i]) * PRIME;
+		return hash ^ (hash >> 32);
+	}
+
+	static inline size_t AlignUp(size_t value) { return (value + MESH_CACHE_ALIGNMENT - 1) & ~(MESH_CACHE_ALIGNMENT - 1); }
+
+	/// @brief Makes buffer view the block, returns false if the block doesn't lie inside the file.
+	template <typename T>
+	static bool ViewBlock(const std::shared_ptr<const MappedFile>& file, const MeshCacheEntry::Block& block, MeshBuffer<T>& buffer)
+	{
+		if (block.offset % MESH_CACHE_ALIGNMENT != 0 || block.offset > file->Size() || block.count > (file->Size() - block.offset) / sizeof(T))
+			return false;
+
+		buffer = block.count > 0 ? MeshBuffer<T>(file, (const T*)(file->Data() + block.offset), (size_t)block.count) : MeshBuffer<T>();
+		return true;
+	}
+
+	/// @brief Copies buffer into the block of the file image.
+	template <typename T>
+	static void CopyBlock(std::vector<char>& image, const MeshCacheEntry::Block& block, const MeshBuffer<T>& buffer)
+	{
+		if (!buffer.empty())
+			std::memcpy(image.data() + block.offset, buffer.data(), buffer.size() * sizeof(T));
+	}
+
+	std::string MeshCachePath(const std::string& sourcePath, bool compressed)
+	{
+		return sourcePath + (compressed ? ".compressed.meshcache" : ".meshcache");
+	}
+
+	bool LoadMeshCache(const std::string& sourcePath, bool compressed, std::vector<Mesh>& meshes)
+	{
+		const std::string cachePath = MeshCachePath(sourcePath, compressed);
+
+		uint64_t sourceSize, sourceTime, cacheSize, cacheTime;
+		if (!GetFileStamp(sourcePath, sourceSize, sourceTime) || !GetFileStamp(cachePath, cacheSize, cacheTime))
+			return false;
+		if (cacheSize < sizeof(MeshCacheHeader))
+			return false;
+
+		std::shared_ptr<const MappedFile> file;
+		try
+		{
+			file = std::make_shared<const MappedFile>(cachePath);
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+
+		MeshCacheHeader header;
+		std::memcpy(&header, file->Data(), sizeof(header));
+		if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION || header.streamCount != MESH_CACHE_STREAM_COUNT ||
+			header.sourceSize != sourceSize || header.sourceTime != sourceTime || header.fileSize != file->Size())
+			return false;
+		if (header.meshCount > (file->Size() - sizeof(MeshCacheHeader)) / sizeof(MeshCacheEntry))
+			return false;
+		if (Checksum(file->Data() + sizeof(MeshCacheHeader), file->Size() - sizeof(MeshCacheHeader)) != header.checksum)
+			return false;
+
+		std::vector<Mesh> loaded(header.meshCount);
+		const char* entries = file->Data() + sizeof(MeshCacheHeader);
+		for (uint32_t i = 0; i < header.meshCount; i++)
+		{
+			MeshCacheEntry entry;
+			std::memcpy(&entry, entries + i * sizeof(MeshCacheEntry), sizeof(entry));
+
+			Mesh& mesh = loaded[i];
+			if (!ViewBlock(file, entry.streams[MESH_CACHE_POSITIONS], mesh.vertices) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_INDICES], mesh.faces) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_TEXCOORDS], mesh.texcoords) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_NORMALS], mesh.normals) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_FACE_NORMALS_X], mesh.faceNormalsX) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_FACE_NORMALS_Y], mesh.faceNormalsY) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_FACE_NORMALS_Z], mesh.faceNormalsZ) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_QUANTIZED_POSITIONS], mesh.quantizedVertices) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_OCT_NORMALS], mesh.octNormals) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_HALF_TEXCOORDS], mesh.halfTexcoords) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_CLUSTERS], mesh.clusters) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_CLUSTER_VERTICES], mesh.clusterVertices) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_CLUSTER_INDICES], mesh.clusterIndices) ||
+				!ViewBlock(file, entry.streams[MESH_CACHE_LODS], mesh.lods))
+				return false;
+
+			mesh.quantizationOffset = Vec3f(entry.quantizationOffset[0], entry.quantizationOffset[1], entry.quantizationOffset[2]);
+			mesh.quantizationScale = Vec3f(entry.quantizationScale[0], entry.quantizationScale[1], entry.quantizationScale[2]);
+			mesh.box = { Vec3f(entry.boxMin[0], entry.boxMin[1], entry.boxMin[2]), Vec3f(entry.boxMax[0], entry.boxMax[1], entry.boxMax[2]) };
+			mesh.sphere = { Vec3f(entry.sphere[0], entry.sphere[1], entry.sphere[2]), entry.sphere[3] };
+
+			mesh.nVertices = (uint32_t)(mesh.IsCompressed() ? mesh.quantizedVertices.size() : mesh.vertices.size());
+			mesh.nFaces = (uint32_t)(mesh.lods.empty() ? mesh.faces.size() : mesh.lods[0].triangleCount * 3);
+		}
+
+		meshes.insert(meshes.end(), std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+		return true;
+	}
+
+	void SaveMeshCache(const std::string& sourcePath, bool compressed, const std::vector<Mesh>& allMeshes, size_t firstMesh)
+	{
+		const Mesh* meshes = allMeshes.data() + firstMesh;
+		const size_t meshCount = allMeshes.size() - firstMesh;
+
+		MeshCacheHeader header = {};
+		header.magic = MESH_CACHE_MAGIC;
+		header.version = MESH_CACHE_VERSION;
+		header.meshCount = (uint32_t)meshCount;
+		header.streamCount = MESH_CACHE_STREAM_COUNT;
+		if (!GetFileStamp(sourcePath, header.sourceSize, header.sourceTime))
+			return;
+
+		// Lay out the blocks, then copy them into a zeroed image of the whole file.
+		std::vector<MeshCacheEntry> entries(meshCount);
+		size_t offset = AlignUp(sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry));
+		auto place = [&offset](MeshCacheEntry::Block& block, size_t count, size_t elementSize)
+		{
+			block.offset = offset;
+			block.count = count;
+			offset = AlignUp(offset + count * elementSize);
+		};
+		for (size_t i = 0; i < meshCount; i++)
+		{
+			place(entries[i].streams[MESH_CACHE_POSITIONS], meshes[i].vertices.size(), sizeof(Vec3f));
+			place(entries[i].streams[MESH_CACHE_INDICES], meshes[i].faces.size(), sizeof(unsigned int));
+			place(entries[i].streams[MESH_CACHE_TEXCOORDS], meshes[i].texcoords.size(), sizeof(Vec2f));
+			place(entries[i].streams[MESH_CACHE_NORMALS], meshes[i].normals.size(), sizeof(Vec3f));
+			place(entries[i].streams[MESH_CACHE_FACE_NORMALS_X], meshes[i].faceNormalsX.size(), sizeof(float));
+			place(entries[i].streams[MESH_CACHE_FACE_NORMALS_Y], meshes[i].faceNormalsY.size(), sizeof(float));
+			place(entries[i].streams[MESH_CACHE_FACE_NORMALS_Z], meshes[i].faceNormalsZ.size(), sizeof(float));
+			place(entries[i].streams[MESH_CACHE_QUANTIZED_POSITIONS], meshes[i].quantizedVertices.size(), sizeof(QuantizedPosition));
+			place(entries[i].streams[MESH_CACHE_OCT_NORMALS], meshes[i].octNormals.size(), sizeof(OctNormal));
+			place(entries[i].streams[MESH_CACHE_HALF_TEXCOORDS], meshes[i].halfTexcoords.size(), sizeof(HalfTexcoord));
+			place(entries[i].streams[MESH_CACHE_CLUSTERS], meshes[i].clusters.size(), sizeof(MeshCluster));
+			place(entries[i].streams[MESH_CACHE_CLUSTER_VERTICES], meshes[i].clusterVertices.size(), sizeof(unsigned int));
+			place(entries[i].streams[MESH_CACHE_CLUSTER_INDICES], meshes[i].clusterIndices.size(), sizeof(uint8_t));
+			place(entries[i].streams[MESH_CACHE_LODS], meshes[i].lods.size(), sizeof(MeshLod));
+
+			const Vec3f& offset = meshes[i].quantizationOffset;
+			const Vec3f& scale = meshes[i].quantizationScale;
+			entries[i].quantizationOffset[0] = offset.x; entries[i].quantizationOffset[1] = offset.y; entries[i].quantizationOffset[2] = offset.z;
+			entries[i].quantizationScale[0] = scale.x; entries[i].quantizationScale[1] = scale.y; entries[i].quantizationScale[2] = scale.z;
+
+			const BoundingBox& box = meshes[i].box;
+			const BoundingSphere& sphere = meshes[i].sphere;
+			entries[i].boxMin[0] = box.min.x; entries[i].boxMin[1] = box.min.y; entries[i].boxMin[2] = box.min.z;
+			entries[i].boxMax[0] = box.max.x; entries[i].boxMax[1] = box.max.y; entries[i].boxMax[2] = box.max.z;
+			entries[i].sphere[0] = sphere.center.x; entries[i].sphere[1] = sphere.center.y; entries[i].sphere[2] = sphere.center.z; entries[i].sphere[3] = sphere.radius;
+		}
+
+		std::vector<char> image(offset, 0);
+		header.fileSize = image.size();
+		if (!entries.empty())
+			std::memcpy(image.data() + sizeof(MeshCacheHeader), entries.data(), entries.size() * sizeof(MeshCacheEntry));
+		for (size_t i = 0; i < meshCount; i++)
+		{
+			CopyBlock(image, entries[i].streams[MESH_CACHE_POSITIONS], meshes[i].vertices);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_INDICES], meshes[i].faces);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_TEXCOORDS], meshes[i].texcoords);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_NORMALS], meshes[i].normals);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_FACE_NORMALS_X], meshes[i].faceNormalsX);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_FACE_NORMALS_Y], meshes[i].faceNormalsY);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_FACE_NORMALS_Z], meshes[i].faceNormalsZ);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_QUANTIZED_POSITIONS], meshes[i].quantizedVertices);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_OCT_NORMALS], meshes[i].octNormals);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_HALF_TEXCOORDS], meshes[i].halfTexcoords);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_CLUSTERS], meshes[i].clusters);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_CLUSTER_VERTICES], meshes[i].clusterVertices);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_CLUSTER_INDICES], meshes[i].clusterIndices);
+			CopyBlock(image, entries[i].streams[MESH_CACHE_LODS], meshes[i].lods);
+		}
+		header.checksum = Checksum(image.data() + sizeof(MeshCacheHeader), image.size() - sizeof(MeshCacheHeader));
+		std::memcpy(image.data(), &header, sizeof(header));
+
+		// Write to a temporary file first, so that a cache is never seen half written.
+		const std::string cachePath = MeshCachePath(sourcePath, compressed);
+		const std::string temporaryPath = cachePath + ".tmp";
+		{
+			std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!out) return;
+			out.write(image.data(), (std::streamsize)image.size());
+			if (!out)
+			{
+				out.close();
+				std::remove(temporaryPath.c_str());
+				return;
+			}
+		}
+		std::remove(cachePath.c_str());
+		if (std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+			std::remove(temporaryPath.c_str());
+	}
+}
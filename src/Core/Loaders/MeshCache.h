@@ -0,0 +1,20 @@
+// Binary cache of loaded meshes, stored next to the model file.
+#pragma once
+
+#include "../Model.h"
+#include <string>
+#include <vector>
+
+namespace MiniRenderer
+{
+	/// @brief Returns the path of the mesh cache of the model file at sourcePath, compressed meshes are cached apart from uncompressed ones.
+	std::string MeshCachePath(const std::string& sourcePath, bool compressed);
+
+	/// @brief Appends the meshes in the cache of the model file at sourcePath to meshes, viewing them in place in the mapped cache.
+	/// Returns false, without changing meshes, if there is no cache or if it is stale, corrupt or of another version.
+	bool LoadMeshCache(const std::string& sourcePath, bool compressed, std::vector<Mesh>& meshes);
+
+	/// @brief Writes the meshes from firstMesh on into the cache of the model file at sourcePath.
+	/// Failing to write the cache isn't an error, the model is only parsed again next time.
+	void SaveMeshCache(const std::string& sourcePath, bool compressed, const std::vector<Mesh>& meshes, size_t firstMesh = 0);
+}
@@ -0,0 +1,704 @@
+#include "MeshOptimizer.h"
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace MiniRenderer
+{
+	static const uint32_t NO_VERTEX = 0xFFFFFFFF;
+
+	/// @brief Bits of the value with -0 turned into 0, so that equal values hash equally.
+	static inline uint32_t FloatBits(float value)
+	{
+		value += 0.0f;
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	/// @brief Returns if the vertices a & b of the mesh have equal attributes.
+	static inline bool SameVertex(const Mesh& mesh, uint32_t a, uint32_t b)
+	{
+		const Vec3f& pa = mesh.vertices[a];
+		const Vec3f& pb = mesh.vertices[b];
+		if (pa.x != pb.x || pa.y != pb.y || pa.z != pb.z) return false;
+		if (!mesh.texcoords.empty() && (mesh.texcoords[a].x != mesh.texcoords[b].x || mesh.texcoords[a].y != mesh.texcoords[b].y)) return false;
+		if (!mesh.normals.empty())
+		{
+			const Vec3f& na = mesh.normals[a];
+			const Vec3f& nb = mesh.normals[b];
+			if (na.x != nb.x || na.y != nb.y || na.z != nb.z) return false;
+		}
+		return true;
+	}
+
+	static inline uint32_t HashVertex(const Mesh& mesh, uint32_t vertex)
+	{
+		const Vec3f& p = mesh.vertices[vertex];
+		uint32_t hash = FloatBits(p.x) * 0x9E3779B1u ^ FloatBits(p.y) * 0x85EBCA77u ^ FloatBits(p.z) * 0xC2B2AE3Du;
+		if (!mesh.texcoords.empty())
+			hash ^= FloatBits(mesh.texcoords[vertex].x) * 0x27D4EB2Fu ^ FloatBits(mesh.texcoords[vertex].y) * 0x165667B1u;
+		if (!mesh.normals.empty())
+		{
+			const Vec3f& n = mesh.normals[vertex];
+			hash ^= FloatBits(n.x) * 0xD3A2646Cu ^ FloatBits(n.y) * 0xFD7046C5u ^ FloatBits(n.z) * 0xB55A4F09u;
+		}
+		return hash ^ (hash >> 15);
+	}
+
+	/// @brief Points every index at the first vertex with the same attributes & drops the triangles with repeated vertices.
+	static void WeldVertices(const Mesh& mesh, std::vector<unsigned int>& indices)
+	{
+		const uint32_t vertexCount = (uint32_t)mesh.vertices.size();
+
+		// Open addressing hash table from attributes to the first vertex having them, sized to stay at most half full.
+		size_t tableSize = 16;
+		while (tableSize < (size_t)vertexCount * 2) tableSize <<= 1;
+		std::vector<uint32_t> table(tableSize, NO_VERTEX);
+		std::vector<uint32_t> weld(vertexCount);
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			size_t slot = HashVertex(mesh, vertex) & (tableSize - 1);
+			while (table[slot] != NO_VERTEX && !SameVertex(mesh, table[slot], vertex))
+				slot = (slot + 1) & (tableSize - 1);
+			if (table[slot] == NO_VERTEX) table[slot] = vertex;
+			weld[vertex] = table[slot];
+		}
+
+		size_t kept = 0;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			uint32_t a = weld[indices[i]], b = weld[indices[i + 1]], c = weld[indices[i + 2]];
+			if (a == b || b == c || c == a) continue;
+			indices[kept++] = a;
+			indices[kept++] = b;
+			indices[kept++] = c;
+		}
+		indices.resize(kept);
+	}
+
+	/// @brief Reorders the triangles so that consecutive ones share vertices that are still in a FIFO vertex cache of cacheSize vertices.
+	/// Tipsify from "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", Sander et al. 2007.
+	static void TipsifyTriangles(std::vector<unsigned int>& indices, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+		if (triangleCount == 0) return;
+
+		// Triangles using every vertex, in compressed rows.
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (unsigned int index : indices) liveTriangles[index]++;
+
+		std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			adjacencyStart[vertex + 1] = adjacencyStart[vertex] + liveTriangles[vertex];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+			for (int k = 0; k < 3; k++)
+				adjacency[fill[indices[triangle * 3 + k]]++] = triangle;
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+		std::vector<unsigned int> output;
+		output.reserve(indices.size());
+
+		uint32_t time = cacheSize + 1;
+		uint32_t cursor = 0;
+		int64_t fanning = indices[0];
+		while (fanning >= 0)
+		{
+			// Emit every triangle around the fanning vertex that is left.
+			candidates.clear();
+			for (uint32_t a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; a++)
+			{
+				uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) continue;
+				emitted[triangle] = true;
+
+				for (int k = 0; k < 3; k++)
+				{
+					uint32_t vertex = indices[triangle * 3 + k];
+					output.push_back(vertex);
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+					if (time - cacheTime[vertex] > cacheSize)
+						cacheTime[vertex] = time++;
+				}
+			}
+
+			// Fan next around the candidate that entered the cache earliest & is still in it after its triangles are emitted.
+			fanning = -1;
+			int64_t bestPriority = 0;
+			for (uint32_t vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0) continue;
+
+				int64_t priority = 0;
+				if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+					priority = time - cacheTime[vertex];
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanning = vertex;
+				}
+			}
+
+			// Dead end: go back to recently used vertices, then on to any vertex with triangles left.
+			while (fanning < 0 && !deadEnd.empty())
+			{
+				uint32_t vertex = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[vertex] > 0) fanning = vertex;
+			}
+			while (fanning < 0 && cursor < vertexCount)
+			{
+				if (liveTriangles[cursor] > 0) fanning = cursor;
+				cursor++;
+			}
+		}
+
+		indices.swap(output);
+	}
+
+	/// @brief Copies the attributes of the vertices in order of first use by indices & points the indices at the copies.
+	static void ReorderVertices(Mesh& mesh, std::vector<unsigned int>& indices)
+	{
+		std::vector<uint32_t> remap(mesh.vertices.size(), NO_VERTEX);
+		uint32_t vertexCount = 0;
+		for (unsigned int& index : indices)
+		{
+			if (remap[index] == NO_VERTEX) remap[index] = vertexCount++;
+			index = remap[index];
+		}
+
+		std::vector<Vec3f> vertices(vertexCount), normals(mesh.normals.empty() ? 0 : vertexCount);
+		std::vector<Vec2f> texcoords(mesh.texcoords.empty() ? 0 : vertexCount);
+		for (uint32_t vertex = 0; vertex < (uint32_t)remap.size(); vertex++)
+		{
+			uint32_t target = remap[vertex];
+			if (target == NO_VERTEX) continue;
+			vertices[target] = mesh.vertices[vertex];
+			if (!texcoords.empty()) texcoords[target] = mesh.texcoords[vertex];
+			if (!normals.empty()) normals[target] = mesh.normals[vertex];
+		}
+
+		mesh.vertices = std::move(vertices);
+		mesh.texcoords = std::move(texcoords);
+		mesh.normals = std::move(normals);
+	}
+
+	void OptimizeMesh(Mesh& mesh)
+	{
+		std::vector<unsigned int> indices(mesh.faces.begin(), mesh.faces.end());
+
+		WeldVertices(mesh, indices);
+		TipsifyTriangles(indices, (uint32_t)mesh.vertices.size(), VERTEX_CACHE_SIZE);
+		ReorderVertices(mesh, indices);
+
+		mesh.faces = std::move(indices);
+		mesh.nVertices = (uint32_t)mesh.vertices.size();
+		mesh.nFaces = (uint32_t)mesh.faces.size();
+	}
+
+	/// @brief Sum of squared distances to a set of planes, weighted by the area of the triangles they come from.
+	struct Quadric
+	{
+		double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+		double weight;
+
+		void AddPlane(double a, double b, double c, double d, double area)
+		{
+			xx += a * a * area; xy += a * b * area; xz += a * c * area; xw += a * d * area;
+			yy += b * b * area; yz += b * c * area; yw += b * d * area;
+			zz += c * c * area; zw += c * d * area;
+			ww += d * d * area;
+			weight += area;
+		}
+
+		void Add(const Quadric& other)
+		{
+			xx += other.xx; xy += other.xy; xz += other.xz; xw += other.xw;
+			yy += other.yy; yz += other.yz; yw += other.yw;
+			zz += other.zz; zw += other.zw;
+			ww += other.ww;
+			weight += other.weight;
+		}
+
+		/// @brief Returns the mean squared distance of point to the planes, together with the planes of other.
+		float Error(const Quadric& other, const Vec3f& point) const
+		{
+			const double x = point.x, y = point.y, z = point.z;
+			double sum = (xx + other.xx) * x * x + (yy + other.yy) * y * y + (zz + other.zz) * z * z + (ww + other.ww) +
+						 2.0 * ((xy + other.xy) * x * y + (xz + other.xz) * x * z + (yz + other.yz) * y * z + (xw + other.xw) * x + (yw + other.yw) * y + (zw + other.zw) * z);
+			double totalWeight = weight + other.weight;
+			return totalWeight > 0.0 ? (float)(std::max(sum, 0.0) / totalWeight) : 0.0f;
+		}
+	};
+
+	/// @brief Edge collapse moving every use of vertex from onto vertex to.
+	struct Collapse
+	{
+		uint32_t from, to;
+		float error;
+	};
+
+	/// @brief Points every vertex at the first vertex with the same position.
+	static std::vector<uint32_t> WeldPositions(const std::vector<Vec3f>& positions)
+	{
+		const uint32_t vertexCount = (uint32_t)positions.size();
+
+		size_t tableSize = 16;
+		while (tableSize < (size_t)vertexCount * 2) tableSize <<= 1;
+		std::vector<uint32_t> table(tableSize, NO_VERTEX);
+		std::vector<uint32_t> weld(vertexCount);
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			const Vec3f& p = positions[vertex];
+			uint32_t hash = FloatBits(p.x) * 0x9E3779B1u ^ FloatBits(p.y) * 0x85EBCA77u ^ FloatBits(p.z) * 0xC2B2AE3Du;
+			size_t slot = (hash ^ (hash >> 15)) & (tableSize - 1);
+			while (table[slot] != NO_VERTEX)
+			{
+				const Vec3f& q = positions[table[slot]];
+				if (q.x == p.x && q.y == p.y && q.z == p.z) break;
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (table[slot] == NO_VERTEX) table[slot] = vertex;
+			weld[vertex] = table[slot];
+		}
+		return weld;
+	}
+
+	/// @brief Collapses edges of the triangles in indices in passes, cheapest first, till at most targetCount triangles are left
+	/// or hardly any edge can be collapsed. Collapses are done onto the vertex to, so the quadric of its position gets the one of from.
+	/// Raises error to the largest distance to the original surface a collapse caused.
+	static void SimplifyTriangles(std::vector<unsigned int>& indices, uint32_t targetCount, const std::vector<Vec3f>& positions,
+								  const std::vector<uint32_t>& weld, const std::vector<bool>& locked, std::vector<Quadric>& quadrics, float& error)
+	{
+		const uint32_t vertexCount = (uint32_t)positions.size();
+		std::vector<uint32_t> adjacencyStart(vertexCount + 1), adjacency;
+		std::vector<Collapse> best(vertexCount), collapses;
+		std::vector<bool> touched(vertexCount);
+		std::vector<uint32_t> remap(vertexCount);
+
+		uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+		while (triangleCount > targetCount)
+		{
+			// Triangles using every vertex, in compressed rows.
+			std::fill(adjacencyStart.begin(), adjacencyStart.end(), 0);
+			for (unsigned int index : indices) adjacencyStart[index + 1]++;
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++) adjacencyStart[vertex + 1] += adjacencyStart[vertex];
+			adjacency.resize(indices.size());
+			std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+				for (int k = 0; k < 3; k++)
+					adjacency[fill[indices[triangle * 3 + k]]++] = triangle;
+
+			// The cheapest edge of every vertex that isn't locked, each vertex is only tried once per pass so that vertices
+			// used by many triangles don't make the pass quadratic.
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+				best[vertex] = { vertex, NO_VERTEX, FLT_MAX };
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					uint32_t a = indices[triangle * 3 + k], b = indices[triangle * 3 + (k + 1) % 3];
+					float errorAB = locked[a] ? FLT_MAX : quadrics[a].Error(quadrics[weld[b]], positions[b]);
+					float errorBA = locked[b] ? FLT_MAX : quadrics[b].Error(quadrics[weld[a]], positions[a]);
+					if (errorAB < best[a].error) best[a] = { a, b, errorAB };
+					if (errorBA < best[b].error) best[b] = { b, a, errorBA };
+				}
+			}
+			collapses.clear();
+			for (const Collapse& collapse : best)
+				if (collapse.to != NO_VERTEX) collapses.push_back(collapse);
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+			// Collapse in order, leaving alone the triangles around a collapsed vertex for the rest of the pass so that the adjacency stays valid.
+			std::fill(touched.begin(), touched.end(), false);
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++) remap[vertex] = vertex;
+			uint32_t removed = 0;
+			for (const Collapse& collapse : collapses)
+			{
+				if (triangleCount - removed <= targetCount) break;
+				if (touched[collapse.from] || touched[collapse.to]) continue;
+
+				// The triangles around from that don't use to must not flip over.
+				bool flips = false;
+				uint32_t collapsed = 0;
+				for (uint32_t a = adjacencyStart[collapse.from]; a < adjacencyStart[collapse.from + 1] && !flips; a++)
+				{
+					const unsigned int* corner = indices.data() + adjacency[a] * 3;
+					if (weld[corner[0]] == weld[collapse.to] || weld[corner[1]] == weld[collapse.to] || weld[corner[2]] == weld[collapse.to])
+					{
+						collapsed++;
+						continue;
+					}
+
+					Vec3f before[3], after[3];
+					for (int k = 0; k < 3; k++)
+					{
+						before[k] = positions[corner[k]];
+						after[k] = corner[k] == collapse.from ? positions[collapse.to] : before[k];
+					}
+					Vec3f normalBefore = Cross(before[1] - before[0], before[2] - before[0]);
+					Vec3f normalAfter = Cross(after[1] - after[0], after[2] - after[0]);
+					flips = Dot(normalBefore, normalAfter) <= 0.0f;
+				}
+				if (flips || collapsed == 0) continue;
+
+				remap[collapse.from] = collapse.to;
+				quadrics[weld[collapse.to]].Add(quadrics[collapse.from]);
+				error = std::max(error, std::sqrt(collapse.error));
+				removed += collapsed;
+				for (uint32_t a = adjacencyStart[collapse.from]; a < adjacencyStart[collapse.from + 1]; a++)
+					for (int k = 0; k < 3; k++)
+						touched[indices[adjacency[a] * 3 + k]] = true;
+			}
+			if (removed == 0) break;
+			const bool stalled = removed < triangleCount / 64;
+
+			// Drop the triangles that lost their area.
+			size_t kept = 0;
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+				if (weld[a] == weld[b] || weld[b] == weld[c] || weld[c] == weld[a]) continue;
+				indices[kept++] = a;
+				indices[kept++] = b;
+				indices[kept++] = c;
+			}
+			indices.resize(kept);
+			triangleCount = (uint32_t)(kept / 3);
+
+			// Few collapses left that don't flip triangles over, further passes would cost more than they remove.
+			if (stalled) break;
+		}
+	}
+
+	void GenerateLods(Mesh& mesh)
+	{
+		const uint32_t fullCount = mesh.nFaces / 3;
+		if (fullCount < MIN_LOD_TRIANGLES * 2 || mesh.IsCompressed()) return;
+
+		std::vector<Vec3f> positions(mesh.vertices.begin(), mesh.vertices.end());
+		std::vector<uint32_t> weld = WeldPositions(positions);
+		const uint32_t vertexCount = (uint32_t)positions.size();
+
+		// Vertices sharing their position with others sit on a seam, collapsing them would tear it open.
+		std::vector<bool> locked(vertexCount, false);
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			if (weld[vertex] != vertex)
+				locked[vertex] = locked[weld[vertex]] = true;
+
+		// Edges used by a single triangle lie on an open border, whose outline has to stay in place.
+		std::vector<uint64_t> edges;
+		edges.reserve(mesh.nFaces);
+		for (uint32_t i = 0; i < mesh.nFaces; i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				uint64_t a = weld[mesh.faces[i + k]], b = weld[mesh.faces[i + (k + 1) % 3]];
+				edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		for (size_t i = 0; i < edges.size();)
+		{
+			size_t j = i + 1;
+			while (j < edges.size() && edges[j] == edges[i]) j++;
+			if (j - i == 1)
+				locked[edges[i] >> 32] = locked[edges[i] & 0xFFFFFFFF] = true;
+			i = j;
+		}
+
+		// Quadrics of the planes of the triangles around every position, kept by the first vertex having it.
+		std::vector<Quadric> quadrics(vertexCount, Quadric());
+		for (uint32_t i = 0; i < mesh.nFaces; i += 3)
+		{
+			const Vec3f& p0 = positions[mesh.faces[i]];
+			Vec3f normal = Cross(positions[mesh.faces[i + 1]] - p0, positions[mesh.faces[i + 2]] - p0);
+			float length = normal.length();
+			if (!(length > 0.0f)) continue;
+
+			double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+			double d = -(a * p0.x + b * p0.y + c * p0.z);
+			for (int k = 0; k < 3; k++)
+				quadrics[weld[mesh.faces[i + k]]].AddPlane(a, b, c, d, length * 0.5);
+		}
+
+		// Every level is simplified further from the one before, collapsing onto the quadrics accumulated so far.
+		std::vector<unsigned int> faces(mesh.faces.begin(), mesh.faces.begin() + mesh.nFaces);
+		std::vector<unsigned int> indices = faces;
+		std::vector<MeshLod> lods = { { 0, fullCount, 0, 0, 0.0f } };
+		float error = 0.0f;
+		while (lods.size() < MAX_LOD_COUNT)
+		{
+			const uint32_t previousCount = (uint32_t)(indices.size() / 3);
+			const uint32_t targetCount = previousCount / 2;
+			if (targetCount < MIN_LOD_TRIANGLES) break;
+
+			SimplifyTriangles(indices, targetCount, positions, weld, locked, quadrics, error);
+
+			// Stop once too much of the mesh is locked to make the level worth its memory.
+			const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+			if (triangleCount > previousCount - previousCount / 4) break;
+
+			TipsifyTriangles(indices, vertexCount, VERTEX_CACHE_SIZE);
+			lods.push_back({ (uint32_t)(faces.size() / 3), triangleCount, 0, 0, error });
+			faces.insert(faces.end(), indices.begin(), indices.end());
+		}
+		if (lods.size() == 1) return;
+
+		mesh.faces = std::move(faces);
+		mesh.lods = std::move(lods);
+	}
+
+	void ComputeNormals(Mesh& mesh)
+	{
+		const size_t triangleCount = mesh.faces.size() / 3;
+		const bool computeVertexNormals = mesh.normals.empty() && mesh.octNormals.empty();
+
+		std::vector<float> faceNormalsX(triangleCount), faceNormalsY(triangleCount), faceNormalsZ(triangleCount);
+		std::vector<Vec3f> vertexNormals(computeVertexNormals ? mesh.nVertices : 0);
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			unsigned int i0 = mesh.faces[triangle * 3], i1 = mesh.faces[triangle * 3 + 1], i2 = mesh.faces[triangle * 3 + 2];
+			Vec3f p0 = mesh.GetVertex(i0);
+
+			// The length of the cross product is twice the area, so summing them weighs the vertex normals by area.
+			Vec3f normal = mesh.counterClockwise ? Cross(mesh.GetVertex(i1) - p0, mesh.GetVertex(i2) - p0) : Cross(mesh.GetVertex(i2) - p0, mesh.GetVertex(i1) - p0);
+			if (computeVertexNormals && triangle < mesh.nFaces / 3)
+			{
+				vertexNormals[i0] += normal;
+				vertexNormals[i1] += normal;
+				vertexNormals[i2] += normal;
+			}
+
+			float length = normal.length();
+			if (length > 0.0f)
+			{
+				faceNormalsX[triangle] = normal.x / length;
+				faceNormalsY[triangle] = normal.y / length;
+				faceNormalsZ[triangle] = normal.z / length;
+			}
+		}
+
+		if (computeVertexNormals)
+		{
+			for (Vec3f& normal : vertexNormals)
+			{
+				float length = normal.length();
+				normal = length > 0.0f ? Vec3f(normal.x / length, normal.y / length, normal.z / length) : Vec3f();
+			}
+			if (mesh.IsCompressed())
+			{
+				std::vector<OctNormal> octNormals(vertexNormals.size());
+				for (size_t i = 0; i < vertexNormals.size(); i++)
+					octNormals[i] = EncodeNormal(vertexNormals[i]);
+				mesh.octNormals = std::move(octNormals);
+			}
+			else
+			{
+				mesh.normals = std::move(vertexNormals);
+			}
+		}
+
+		mesh.faceNormalsX = std::move(faceNormalsX);
+		mesh.faceNormalsY = std::move(faceNormalsY);
+		mesh.faceNormalsZ = std::move(faceNormalsZ);
+	}
+
+	/// @brief Computes the normal cone of the cluster from the face normals of its triangles.
+	static void ComputeNormalCone(const Mesh& mesh, MeshCluster& cluster)
+	{
+		const uint32_t lastTriangle = cluster.firstTriangle + cluster.triangleCount;
+
+		Vec3f axis;
+		for (uint32_t i = cluster.firstTriangle; i < lastTriangle; i++)
+			axis += Vec3f(mesh.faceNormalsX[i], mesh.faceNormalsY[i], mesh.faceNormalsZ[i]);
+
+		// Clusters whose normals spread over more than a hemisphere(or close to it) can't be culled by their cone.
+		cluster.coneAxis = Vec3f();
+		cluster.coneCutoff = 1.0f;
+		float length = axis.length();
+		if (length <= 0.0f) return;
+		axis = Vec3f(axis.x / length, axis.y / length, axis.z / length);
+
+		float minDot = 1.0f;
+		for (uint32_t i = cluster.firstTriangle; i < lastTriangle; i++)
+		{
+			Vec3f normal(mesh.faceNormalsX[i], mesh.faceNormalsY[i], mesh.faceNormalsZ[i]);
+			if (normal.x != 0.0f || normal.y != 0.0f || normal.z != 0.0f)
+				minDot = std::min(minDot, Dot(axis, normal));
+		}
+		if (minDot <= 0.1f) return;
+
+		cluster.coneAxis = axis;
+		cluster.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+
+	void ComputeBounds(Mesh& mesh)
+	{
+		std::vector<Vec3f> decoded;
+		const Vec3f* positions = mesh.vertices.data();
+		if (mesh.IsCompressed())
+		{
+			decoded.resize(mesh.nVertices);
+			for (uint32_t i = 0; i < mesh.nVertices; i++)
+				decoded[i] = mesh.GetVertex(i);
+			positions = decoded.data();
+		}
+
+		mesh.box = ComputeBoundingBox(positions, mesh.nVertices);
+		mesh.sphere = ComputeBoundingSphere(mesh.box, positions, mesh.nVertices);
+
+		// Greedily add triangles to the current cluster in order, starting a new one when a triangle doesn't fit or a level of detail starts.
+		const uint32_t triangleCount = (uint32_t)(mesh.faces.size() / 3);
+		std::vector<MeshLod> lods(mesh.lods.begin(), mesh.lods.end());
+		size_t nextLod = 0;
+		std::vector<MeshCluster> clusters;
+		std::vector<unsigned int> clusterVertices;
+		std::vector<uint8_t> clusterIndices(triangleCount * 3);
+		std::vector<uint8_t> localIndex(mesh.nVertices, 0xFF);
+		std::vector<Vec3f> corners;
+
+		auto finishCluster = [&]()
+		{
+			MeshCluster& cluster = clusters.back();
+			corners.clear();
+			for (uint32_t i = 0; i < cluster.vertexCount; i++)
+			{
+				unsigned int vertex = clusterVertices[cluster.firstVertex + i];
+				corners.push_back(positions[vertex]);
+				localIndex[vertex] = 0xFF;
+			}
+			cluster.box = ComputeBoundingBox(corners.data(), corners.size());
+			cluster.sphere = ComputeBoundingSphere(cluster.box, corners.data(), corners.size());
+			ComputeNormalCone(mesh, cluster);
+		};
+
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			const unsigned int* corner = mesh.faces.data() + triangle * 3;
+			bool startCluster = clusters.empty();
+			if (nextLod < lods.size() && lods[nextLod].firstTriangle == triangle)
+			{
+				if (!startCluster)
+					finishCluster();
+				startCluster = true;
+				lods[nextLod++].firstCluster = (uint32_t)clusters.size();
+			}
+			else if (!startCluster)
+			{
+				const MeshCluster& cluster = clusters.back();
+				uint32_t newVertices = (localIndex[corner[0]] == 0xFF) + (localIndex[corner[1]] == 0xFF && corner[1] != corner[0]) +
+									   (localIndex[corner[2]] == 0xFF && corner[2] != corner[0] && corner[2] != corner[1]);
+				if (cluster.vertexCount + newVertices > MAX_CLUSTER_VERTICES || cluster.triangleCount == MAX_CLUSTER_TRIANGLES)
+				{
+					finishCluster();
+					startCluster = true;
+				}
+			}
+
+			if (startCluster)
+			{
+				MeshCluster cluster = {};
+				cluster.firstTriangle = triangle;
+				cluster.firstVertex = (uint32_t)clusterVertices.size();
+				clusters.push_back(cluster);
+			}
+
+			MeshCluster& cluster = clusters.back();
+			for (int k = 0; k < 3; k++)
+			{
+				if (localIndex[corner[k]] == 0xFF)
+				{
+					localIndex[corner[k]] = (uint8_t)cluster.vertexCount++;
+					clusterVertices.push_back(corner[k]);
+				}
+				clusterIndices[triangle * 3 + k] = localIndex[corner[k]];
+			}
+			cluster.triangleCount++;
+		}
+		if (!clusters.empty())
+			finishCluster();
+		for (size_t i = 0; i < lods.size(); i++)
+			lods[i].clusterCount = (i + 1 < lods.size() ? lods[i + 1].firstCluster : (uint32_t)clusters.size()) - lods[i].firstCluster;
+
+		mesh.clusters = std::move(clusters);
+		mesh.clusterVertices = std::move(clusterVertices);
+		mesh.clusterIndices = std::move(clusterIndices);
+		if (!lods.empty())
+			mesh.lods = std::move(lods);
+	}
+
+	void ComputeEdges(Mesh& mesh)
+	{
+		// Vertices split along seams share their edges, so edges are keyed by the first vertex at each position.
+		std::vector<Vec3f> positions(mesh.nVertices);
+		for (uint32_t vertex = 0; vertex < mesh.nVertices; vertex++)
+			positions[vertex] = mesh.GetVertex(vertex);
+		std::vector<uint32_t> weld = WeldPositions(positions);
+
+		std::vector<uint64_t> keys;
+		keys.reserve(mesh.nFaces);
+		for (uint32_t i = 0; i < mesh.nFaces; i += 3)
+		{
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uint32_t a = weld[mesh.faces[i + j]], b = weld[mesh.faces[i + (j + 1) % 3]];
+				if (a == b) continue;
+				keys.push_back(a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a);
+			}
+		}
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+		std::vector<uint32_t> edges(keys.size() * 2);
+		for (size_t edge = 0; edge < keys.size(); edge++)
+		{
+			edges[edge * 2] = (uint32_t)(keys[edge] >> 32);
+			edges[edge * 2 + 1] = (uint32_t)keys[edge];
+		}
+		mesh.edges = std::move(edges);
+	}
+
+	void CompressMesh(Mesh& mesh)
+	{
+		if (mesh.IsCompressed() || mesh.vertices.empty()) return;
+
+		Vec3f boundsMin = mesh.vertices[0], boundsMax = mesh.vertices[0];
+		for (const Vec3f& vertex : mesh.vertices)
+		{
+			boundsMin = _mm_min_ps(boundsMin._mValue, vertex._mValue);
+			boundsMax = _mm_max_ps(boundsMax._mValue, vertex._mValue);
+		}
+		Vec3f extent = boundsMax - boundsMin;
+		mesh.quantizationOffset = Vec3f(boundsMin.x, boundsMin.y, boundsMin.z);
+		mesh.quantizationScale = Vec3f(extent.x / 65535.0f, extent.y / 65535.0f, extent.z / 65535.0f);
+
+		std::vector<QuantizedPosition> quantizedVertices(mesh.vertices.size());
+		for (size_t i = 0; i < quantizedVertices.size(); i++)
+			quantizedVertices[i] = EncodePosition(mesh.vertices[i], mesh.quantizationOffset, mesh.quantizationScale);
+
+		std::vector<OctNormal> octNormals(mesh.normals.size());
+		for (size_t i = 0; i < octNormals.size(); i++)
+			octNormals[i] = EncodeNormal(mesh.normals[i]);
+
+		std::vector<HalfTexcoord> halfTexcoords(mesh.texcoords.size());
+		for (size_t i = 0; i < halfTexcoords.size(); i++)
+			halfTexcoords[i] = EncodeTexcoord(mesh.texcoords[i]);
+
+		mesh.quantizedVertices = std::move(quantizedVertices);
+		mesh.octNormals = std::move(octNormals);
+		mesh.halfTexcoords = std::move(halfTexcoords);
+		mesh.vertices = MeshBuffer<Vec3f>();
+		mesh.normals = MeshBuffer<Vec3f>();
+		mesh.texcoords = MeshBuffer<Vec2f>();
+	}
+}
@@ -0,0 +1,51 @@
+// Prepares mesh data for faster drawing.
+#pragma once
+
+#include "../Model.h"
+
+namespace MiniRenderer
+{
+	/// @brief Size of the post transform vertex cache the triangle order is optimized for.
+	static const uint32_t VERTEX_CACHE_SIZE = 16;
+
+	/// @brief Most vertices & triangles in a MeshCluster.
+	static const uint32_t MAX_CLUSTER_VERTICES = 64;
+	static const uint32_t MAX_CLUSTER_TRIANGLES = 124;
+
+	/// @brief Prepares a freshly loaded, uncompressed mesh for drawing:
+	/// welds vertices with equal attributes & drops the triangles that become degenerate,
+	/// orders the triangles for post transform vertex cache reuse(Tipsify),
+	/// then orders the vertices by first use & drops the unused ones.
+	void OptimizeMesh(Mesh& mesh);
+
+	/// @brief Most levels of detail of a Mesh, the full detail one included.
+	static const uint32_t MAX_LOD_COUNT = 5;
+
+	/// @brief Fewest triangles a level of detail is simplified down to.
+	static const uint32_t MIN_LOD_TRIANGLES = 64;
+
+	/// @brief Appends coarser & coarser levels of detail of the mesh to its faces, each with about half the triangles of the one before.
+	/// Levels are simplified by collapsing edges in order of their quadric error("Surface Simplification Using Quadric Error Metrics",
+	/// Garland & Heckbert 1997) onto existing vertices, so all levels share the vertices of the mesh. Vertices on open borders & on seams
+	/// between different normals or texture coordinates are kept. Needs an uncompressed mesh, & should run after OptimizeMesh.
+	void GenerateLods(Mesh& mesh);
+
+	/// @brief Computes the face normals of the mesh, and area weighted vertex normals if the mesh has none.
+	/// Normals point along Cross(p2 - p0, p1 - p0) of their triangles, the side Model::Draw lights, or the opposite way for counter clockwise meshes.
+	void ComputeNormals(Mesh& mesh);
+
+	/// @brief Computes the bounding box & sphere of the mesh & splits its faces into clusters of at most MAX_CLUSTER_VERTICES vertices
+	/// & MAX_CLUSTER_TRIANGLES triangles, each with its own bounds & normal cone. Needs the face normals(see ComputeNormals).
+	/// Every level of detail gets clusters of its own.
+	/// Clusters are runs of consecutive triangles, which are close together once the triangles are ordered by OptimizeMesh.
+	void ComputeBounds(Mesh& mesh);
+
+	/// @brief Computes the unique edges of the full detail faces of the mesh, each once however many triangles share it,
+	/// so a wireframe draws every line once. Vertices at the same position count as one.
+	void ComputeEdges(Mesh& mesh);
+
+	/// @brief Replaces the vertices, normals & texture coordinates of the mesh with their compressed forms:
+	/// 16 bit positions quantized inside the mesh bounds, octahedral normals & half precision texture coordinates.
+	/// Cuts vertex data from 40 to 16 bytes per vertex, positions are off by at most half the bounds / 65535 per axis.
+	void CompressMesh(Mesh& mesh);
+}
@@ -0,0 +1,578 @@
+#include "ObjLoader.h"
+#include "../MappedFile.h"
+#include "../JobSystem.h"
+#include <cstring>
+#include <climits>
+#include <iostream>
+#include <unordered_map>
+#include <cmath>
+#include <stdexcept>
+
+namespace MiniRenderer
+{
+	/// @brief Statements parsed from a range of lines of an OBJ file, in the order they appear.
+	struct ObjChunk
+	{
+		/// @brief A run of consecutive attribute(v, vt & vn) or face statements, or the offsets of a run in its chunk.
+		struct Run
+		{
+			bool faces;			// True for face corners, false for attributes.
+			size_t positions;	// Number of positions in this run.
+			size_t texcoords;	// Number of texture coordinates in this run.
+			size_t normals;		// Number of normals in this run.
+			size_t corners;		// Number of triangle corners in this run.
+		};
+
+		/// @brief 1 based OBJ indices of a triangle corner, 0 if the corner has no such attribute.
+		/// Negative indices are relative to the chunk, see ParseObjLines.
+		struct Corner
+		{
+			int64_t position, texcoord, normal;
+		};
+
+		std::vector<Vec3f> positions;
+		std::vector<Vec2f> texcoords;
+		std::vector<Vec3f> normals;
+		std::vector<Corner> corners;	// 3 per triangle.
+		std::vector<Run> runs;
+	};
+
+	/// @brief Chunks smaller than this are not worth a thread of their own.
+	static const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+	/// @brief Subtracted from the indices of relative face corners, to tell them apart from absolute ones.
+	static const int64_t RELATIVE_INDEX_BIAS = 1LL << 40;
+
+	/// @brief Index of an attribute a corner doesn't have.
+	static const uint32_t NO_INDEX = 0xFFFFFFFF;
+
+	/// @brief Exact powers of 10 in double precision.
+	static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+											1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	static inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+	static inline const char* SkipSpaces(const char* p, const char* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t')) p++;
+		return p;
+	}
+
+	/// @brief Parses a decimal integer at p & moves p past it. Returns false if there is no number at p or it does not fit in an int.
+	static inline bool ParseInt(const char*& p, const char* end, int& value)
+	{
+		const char* start = p;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = *p++ == '-';
+
+		if (p == end || !IsDigit(*p))
+		{
+			p = start;
+			return false;
+		}
+
+		// Numbers too large for an int are a parse error, like an index that can't exist.
+		int64_t result = 0;
+		while (p < end && IsDigit(*p))
+		{
+			result = result * 10 + (*p++ - '0');
+			if (result > INT_MAX)
+			{
+				p = start;
+				return false;
+			}
+		}
+
+		value = (int)(negative ? -result : result);
+		return true;
+	}
+
+	/// @brief Parses a floating point number like 1, -0.5 or 1.5e-3 at p & moves p past it. Returns false if there is no number at p.
+	static inline bool ParseFloat(const char*& p, const char* end, float& value)
+	{
+		const char* start = p;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = *p++ == '-';
+
+		// Gather up to 19 significant digits into an integer, the rest only change the exponent.
+		uint64_t mantissa = 0;
+		int digits = 0, exponent = 0;
+		bool anyDigit = false;
+		for (; p < end && IsDigit(*p); p++, anyDigit = true)
+		{
+			if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; }
+			else exponent++;
+		}
+
+		if (p < end && *p == '.')
+		{
+			for (p++; p < end && IsDigit(*p); p++, anyDigit = true)
+			{
+				if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; exponent--; }
+			}
+		}
+
+		if (!anyDigit)
+		{
+			p = start;
+			return false;
+		}
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char* exponentStart = p++;
+			int e = 0;
+			if (ParseInt(p, end, e))
+				exponent += e;
+			else
+				p = exponentStart;
+		}
+
+		// Dividing by an exact power of 10 rounds only once.
+		double result = (double)mantissa;
+		if (exponent < 0)
+			result = exponent >= -22 ? result / POWERS_OF_TEN[-exponent] : result * std::pow(10.0, exponent);
+		else if (exponent > 0)
+			result = exponent <= 22 ? result * POWERS_OF_TEN[exponent] : result * std::pow(10.0, exponent);
+
+		value = (float)(negative ? -result : result);
+		return true;
+	}
+
+	/// @brief Returns the end of the line starting at p, without the new line character.
+	static inline const char* LineEnd(const char* p, const char* end)
+	{
+		const char* newLine = (const char*)std::memchr(p, '\n', end - p);
+		return newLine != nullptr ? newLine : end;
+	}
+
+	/// @brief Returns 'v', 't', 'n' or 'f' if the line at p is a v, vt, vn or f statement, 0 otherwise.
+	static inline char StatementType(const char* p, const char* lineEnd)
+	{
+		if (lineEnd - p < 2) return 0;
+		if (p[1] == ' ' || p[1] == '\t')
+			return (p[0] == 'v' || p[0] == 'f') ? p[0] : 0;
+		if (p[0] == 'v' && (p[1] == 't' || p[1] == 'n') && lineEnd - p >= 3 && (p[2] == ' ' || p[2] == '\t'))
+			return p[1];
+		return 0;
+	}
+
+	/// @brief Parses up to count floats separated by spaces at p, returns how many were parsed.
+	static inline int ParseFloats(const char* p, const char* lineEnd, float* values, int count)
+	{
+		int parsed = 0;
+		for (; parsed < count; parsed++)
+		{
+			p = SkipSpaces(p, lineEnd);
+			if (!ParseFloat(p, lineEnd, values[parsed])) break;
+		}
+		return parsed;
+	}
+
+	/// @brief Turns the OBJ index into the form stored in ObjChunk::Corner, given the number of attributes of its kind parsed so far in the chunk.
+	static inline int64_t ChunkIndex(int index, size_t parsed)
+	{
+		return index >= 0 ? index : (int64_t)parsed + index + 1 - RELATIVE_INDEX_BIAS;
+	}
+
+	/// @brief Adds an attribute run to the chunk if the last run was faces & returns the current attribute run.
+	static inline ObjChunk::Run& AttributeRun(ObjChunk& chunk)
+	{
+		if (chunk.runs.empty() || chunk.runs.back().faces)
+			chunk.runs.push_back({ false, 0, 0, 0, 0 });
+		return chunk.runs.back();
+	}
+
+	/// @brief Parses the lines in [begin, end) into chunk. begin has to be the start of a line.
+	/// Polygons are split into a fan of triangles around their first corner. Positive indices are kept as they are,
+	/// relative (negative) ones can only be resolved against the attributes of this chunk, so they are stored as the
+	/// 1 based index into the chunk's array minus RELATIVE_INDEX_BIAS & rebased in BuildMeshes.
+	static void ParseObjLines(const char* begin, const char* end, ObjChunk& chunk)
+	{
+		// Count the statements first, so that the arrays rarely grow while parsing.
+		size_t positionCount = 0, texcoordCount = 0, normalCount = 0, faceCount = 0;
+		for (const char* p = begin; p < end;)
+		{
+			p = SkipSpaces(p, end);
+			const char* lineEnd = LineEnd(p, end);
+			switch (StatementType(p, lineEnd))
+			{
+			case 'v': positionCount++; break;
+			case 't': texcoordCount++; break;
+			case 'n': normalCount++; break;
+			case 'f': faceCount++; break;
+			}
+			p = lineEnd + 1;
+		}
+		chunk.positions.reserve(positionCount);
+		chunk.texcoords.reserve(texcoordCount);
+		chunk.normals.reserve(normalCount);
+		chunk.corners.reserve(faceCount * 3);
+
+		std::vector<ObjChunk::Corner> polygon;
+		for (const char* p = begin; p < end;)
+		{
+			p = SkipSpaces(p, end);
+			const char* lineEnd = LineEnd(p, end);
+			char type = StatementType(p, lineEnd);
+			const char* q = p + (type == 't' || type == 'n' ? 2 : 1);
+			p = lineEnd + 1;
+
+			float values[3];
+			if (type == 'v')
+			{
+				// v x y z
+				if (ParseFloats(q, lineEnd, values, 3) < 3) continue;
+				AttributeRun(chunk).positions++;
+				chunk.positions.push_back(Vec3f(values[0], values[1], values[2]));
+			}
+			else if (type == 't')
+			{
+				// vt u [v [w]]
+				int parsed = ParseFloats(q, lineEnd, values, 2);
+				if (parsed < 1) continue;
+				AttributeRun(chunk).texcoords++;
+				chunk.texcoords.push_back(Vec2f(values[0], parsed > 1 ? values[1] : 0.0f));
+			}
+			else if (type == 'n')
+			{
+				// vn x y z
+				if (ParseFloats(q, lineEnd, values, 3) < 3) continue;
+				AttributeRun(chunk).normals++;
+				chunk.normals.push_back(Vec3f(values[0], values[1], values[2]));
+			}
+			else if (type == 'f')
+			{
+				// f v1 v2 v3 ..., every corner being v, v/vt, v//vn or v/vt/vn.
+				polygon.clear();
+				while (true)
+				{
+					ObjChunk::Corner corner = { 0, 0, 0 };
+					int index;
+					q = SkipSpaces(q, lineEnd);
+					if (!ParseInt(q, lineEnd, index) || index == 0) break;
+					corner.position = ChunkIndex(index, chunk.positions.size());
+					if (q < lineEnd && *q == '/')
+					{
+						q++;
+						if (ParseInt(q, lineEnd, index))	// May be empty as in v//vn.
+							corner.texcoord = ChunkIndex(index, chunk.texcoords.size());
+						if (q < lineEnd && *q == '/')
+						{
+							q++;
+							if (ParseInt(q, lineEnd, index))
+								corner.normal = ChunkIndex(index, chunk.normals.size());
+						}
+					}
+					polygon.push_back(corner);
+				}
+				if (polygon.size() < 3) continue;
+
+				if (chunk.runs.empty() || !chunk.runs.back().faces)
+					chunk.runs.push_back({ true, 0, 0, 0, 0 });
+				chunk.runs.back().corners += (polygon.size() - 2) * 3;
+				for (size_t i = 1; i + 1 < polygon.size(); i++)
+				{
+					chunk.corners.push_back(polygon[0]);
+					chunk.corners.push_back(polygon[i]);
+					chunk.corners.push_back(polygon[i + 1]);
+				}
+			}
+		}
+	}
+
+	/// @brief Calls func(meshIndex, chunkIndex, run, first) for every run of the chunks in order.
+	/// first holds the offsets of the run in the arrays of its chunk. A new mesh starts at every attribute run that follows faces.
+	template <typename Func>
+	static void ForEachRun(const std::vector<ObjChunk>& chunks, Func func)
+	{
+		int mesh = -1;
+		bool lastRunWasFaces = true;	// So that the first attributes start a mesh.
+		for (size_t chunk = 0; chunk < chunks.size(); chunk++)
+		{
+			ObjChunk::Run first = { false, 0, 0, 0, 0 };
+			for (const ObjChunk::Run& run : chunks[chunk].runs)
+			{
+				if ((!run.faces && lastRunWasFaces) || mesh < 0)
+					mesh++;
+				lastRunWasFaces = run.faces;
+
+				first.faces = run.faces;
+				func(mesh, chunk, run, first);
+				first.positions += run.positions;
+				first.texcoords += run.texcoords;
+				first.normals += run.normals;
+				first.corners += run.corners;
+			}
+		}
+	}
+
+	/// @brief Number of attributes of a kind before a chunk or a mesh in the whole file, to rebase OBJ indices.
+	struct ObjBases
+	{
+		int64_t positions = 0, texcoords = 0, normals = 0;
+	};
+
+	/// @brief A run of the chunks that belongs to a mesh.
+	struct ObjMeshRun
+	{
+		size_t chunk;
+		ObjChunk::Run run, first;
+	};
+
+	/// @brief Attributes of one kind of a mesh. OBJ indices are global to the file, so the attributes of other meshes that its faces use
+	/// are copied in after its own, once each.
+	template <class T>
+	struct ObjMeshAttributes
+	{
+		const std::vector<ObjChunk>& chunks;
+		const std::vector<ObjBases>& chunkBases;
+		std::vector<T> ObjChunk::* chunkValues;	// Attributes of this kind in a chunk.
+		int64_t ObjBases::* kind;				// Count of this kind in ObjBases.
+		int64_t meshBase, meshSize, fileSize;
+		std::vector<T> values;
+		std::unordered_map<int64_t, uint32_t> copies;	// Index of the copy of every attribute of another mesh, by its index in the file.
+
+		/// @brief Turns the stored index of a corner into a 0 based index into values, NO_INDEX if the corner has none or it doesn't exist.
+		uint32_t Resolve(int64_t index, const ObjBases& chunkBase)
+		{
+			if (index == 0) return NO_INDEX;
+			int64_t global = (index > 0 ? index : chunkBase.*kind + index + RELATIVE_INDEX_BIAS) - 1;
+			if (global >= meshBase && global < meshBase + meshSize)
+				return (uint32_t)(global - meshBase);
+			if (global < 0 || global >= fileSize)
+				return NO_INDEX;
+
+			auto copy = copies.find(global);
+			if (copy != copies.end())
+				return copy->second;
+
+			// The last chunk starting at or before the attribute holds it.
+			size_t chunk = chunks.size() - 1;
+			while (chunkBases[chunk].*kind > global)
+				chunk--;
+			uint32_t local = (uint32_t)values.size();
+			values.push_back((chunks[chunk].*chunkValues)[(size_t)(global - chunkBases[chunk].*kind)]);
+			copies.emplace(global, local);
+			return local;
+		}
+	};
+
+	/// @brief Fills mesh from its runs, merging corners with the same position, texture coordinate & normal into one vertex.
+	/// Returns the number of triangles dropped as they use positions that don't exist in the file.
+	static size_t BuildMesh(const std::vector<ObjChunk>& chunks, const std::vector<ObjBases>& chunkBases, const std::vector<ObjMeshRun>& runs,
+							const ObjBases& base, const ObjBases& size, const ObjBases& fileSize, size_t cornerCount, Mesh& mesh)
+	{
+		// Gather the attributes of the mesh.
+		ObjMeshAttributes<Vec3f> positions = { chunks, chunkBases, &ObjChunk::positions, &ObjBases::positions, base.positions, size.positions, fileSize.positions };
+		ObjMeshAttributes<Vec2f> texcoords = { chunks, chunkBases, &ObjChunk::texcoords, &ObjBases::texcoords, base.texcoords, size.texcoords, fileSize.texcoords };
+		ObjMeshAttributes<Vec3f> normals = { chunks, chunkBases, &ObjChunk::normals, &ObjBases::normals, base.normals, size.normals, fileSize.normals };
+		positions.values.reserve((size_t)size.positions);
+		texcoords.values.reserve((size_t)size.texcoords);
+		normals.values.reserve((size_t)size.normals);
+		for (const ObjMeshRun& meshRun : runs)
+		{
+			if (meshRun.run.faces) continue;
+			const ObjChunk& chunk = chunks[meshRun.chunk];
+			positions.values.insert(positions.values.end(), chunk.positions.begin() + meshRun.first.positions, chunk.positions.begin() + meshRun.first.positions + meshRun.run.positions);
+			texcoords.values.insert(texcoords.values.end(), chunk.texcoords.begin() + meshRun.first.texcoords, chunk.texcoords.begin() + meshRun.first.texcoords + meshRun.run.texcoords);
+			normals.values.insert(normals.values.end(), chunk.normals.begin() + meshRun.first.normals, chunk.normals.begin() + meshRun.first.normals + meshRun.run.normals);
+		}
+
+		std::vector<unsigned int> faces;
+		faces.reserve(cornerCount);
+
+		// Without texture coordinates & normals, its own or used from other meshes, every position is a vertex of its own.
+		bool positionsOnly = texcoords.values.empty() && normals.values.empty();
+		for (const ObjMeshRun& meshRun : runs)
+		{
+			if (!meshRun.run.faces) continue;
+			const ObjChunk::Corner* corners = chunks[meshRun.chunk].corners.data() + meshRun.first.corners;
+			for (size_t i = 0; positionsOnly && i < meshRun.run.corners; i++)
+				positionsOnly = corners[i].texcoord == 0 && corners[i].normal == 0;
+		}
+
+		// Open addressing hash table from corners to vertices, sized to stay at most half full.
+		struct VertexKey { uint32_t position, texcoord, normal; };
+		std::vector<VertexKey> keys;
+		std::vector<uint32_t> table;
+		size_t tableMask = 0;
+		if (!positionsOnly)
+		{
+			size_t tableSize = 16;
+			while (tableSize < cornerCount * 2) tableSize <<= 1;
+			table.assign(tableSize, NO_INDEX);
+			tableMask = tableSize - 1;
+			keys.reserve(cornerCount < (size_t)size.positions ? (size_t)size.positions : cornerCount);
+		}
+
+		size_t dropped = 0;
+		for (const ObjMeshRun& meshRun : runs)
+		{
+			if (!meshRun.run.faces) continue;
+			const ObjBases& chunkBase = chunkBases[meshRun.chunk];
+			const ObjChunk::Corner* corners = chunks[meshRun.chunk].corners.data() + meshRun.first.corners;
+			for (size_t i = 0; i < meshRun.run.corners; i += 3)
+			{
+				// Triangles using positions that don't exist are dropped, other attributes that don't exist are left out.
+				VertexKey triangle[3];
+				bool valid = true;
+				for (int k = 0; k < 3; k++)
+				{
+					const ObjChunk::Corner& corner = corners[i + k];
+					triangle[k].position = positions.Resolve(corner.position, chunkBase);
+					triangle[k].texcoord = positionsOnly ? NO_INDEX : texcoords.Resolve(corner.texcoord, chunkBase);
+					triangle[k].normal = positionsOnly ? NO_INDEX : normals.Resolve(corner.normal, chunkBase);
+					valid &= triangle[k].position != NO_INDEX;
+				}
+				if (!valid)
+				{
+					dropped++;
+					continue;
+				}
+
+				for (const VertexKey& key : triangle)
+				{
+					if (positionsOnly)
+					{
+						faces.push_back(key.position);
+						continue;
+					}
+
+					uint32_t hash = key.position * 0x9E3779B1u ^ key.texcoord * 0x85EBCA77u ^ key.normal * 0xC2B2AE3Du;
+					size_t slot = (hash ^ (hash >> 15)) & tableMask;
+					while (table[slot] != NO_INDEX)
+					{
+						const VertexKey& other = keys[table[slot]];
+						if (other.position == key.position && other.texcoord == key.texcoord && other.normal == key.normal) break;
+						slot = (slot + 1) & tableMask;
+					}
+					if (table[slot] == NO_INDEX)
+					{
+						table[slot] = (uint32_t)keys.size();
+						keys.push_back(key);
+					}
+					faces.push_back(table[slot]);
+				}
+			}
+		}
+
+		if (positionsOnly)
+		{
+			mesh.vertices = std::move(positions.values);
+		}
+		else
+		{
+			// Build the vertex buffer from the unique corners, in the order they are first used.
+			std::vector<Vec3f> vertices(keys.size()), vertexNormals(normals.values.empty() ? 0 : keys.size());
+			std::vector<Vec2f> vertexTexcoords(texcoords.values.empty() ? 0 : keys.size());
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				vertices[i] = positions.values[keys[i].position];
+				if (!vertexTexcoords.empty() && keys[i].texcoord != NO_INDEX) vertexTexcoords[i] = texcoords.values[keys[i].texcoord];
+				if (!vertexNormals.empty() && keys[i].normal != NO_INDEX) vertexNormals[i] = normals.values[keys[i].normal];
+			}
+			mesh.vertices = std::move(vertices);
+			mesh.texcoords = std::move(vertexTexcoords);
+			mesh.normals = std::move(vertexNormals);
+		}
+		mesh.faces = std::move(faces);
+		mesh.nVertices = (uint32_t)mesh.vertices.size();
+		mesh.nFaces = (uint32_t)mesh.faces.size();
+		return dropped;
+	}
+
+	/// @brief Distributes the statements of the chunks, in order, into new meshes & builds them in parallel.
+	/// Returns the number of triangles dropped as they use positions that don't exist in the file.
+	static size_t BuildMeshes(const std::vector<ObjChunk>& chunks, std::vector<Mesh>& meshes)
+	{
+		// First attribute of every chunk in the whole file.
+		std::vector<ObjBases> chunkBases(chunks.size());
+		for (size_t i = 1; i < chunks.size(); i++)
+		{
+			chunkBases[i].positions = chunkBases[i - 1].positions + (int64_t)chunks[i - 1].positions.size();
+			chunkBases[i].texcoords = chunkBases[i - 1].texcoords + (int64_t)chunks[i - 1].texcoords.size();
+			chunkBases[i].normals = chunkBases[i - 1].normals + (int64_t)chunks[i - 1].normals.size();
+		}
+
+		// Runs, sizes & number of corners of every mesh.
+		std::vector<std::vector<ObjMeshRun>> meshRuns;
+		std::vector<ObjBases> meshSizes;
+		std::vector<size_t> cornerCounts;
+		ForEachRun(chunks, [&](int mesh, size_t chunk, const ObjChunk::Run& run, const ObjChunk::Run& first)
+		{
+			if (mesh == (int)meshRuns.size())
+			{
+				meshRuns.emplace_back();
+				meshSizes.emplace_back();
+				cornerCounts.push_back(0);
+			}
+			meshRuns[mesh].push_back({ chunk, run, first });
+			meshSizes[mesh].positions += (int64_t)run.positions;
+			meshSizes[mesh].texcoords += (int64_t)run.texcoords;
+			meshSizes[mesh].normals += (int64_t)run.normals;
+			cornerCounts[mesh] += run.corners;
+		});
+
+		std::vector<ObjBases> meshBases(meshRuns.size());
+		for (size_t i = 1; i < meshRuns.size(); i++)
+		{
+			meshBases[i].positions = meshBases[i - 1].positions + meshSizes[i - 1].positions;
+			meshBases[i].texcoords = meshBases[i - 1].texcoords + meshSizes[i - 1].texcoords;
+			meshBases[i].normals = meshBases[i - 1].normals + meshSizes[i - 1].normals;
+		}
+
+		ObjBases fileSize;
+		if (!chunks.empty())
+		{
+			fileSize.positions = chunkBases.back().positions + (int64_t)chunks.back().positions.size();
+			fileSize.texcoords = chunkBases.back().texcoords + (int64_t)chunks.back().texcoords.size();
+			fileSize.normals = chunkBases.back().normals + (int64_t)chunks.back().normals.size();
+		}
+
+		size_t firstMesh = meshes.size();
+		meshes.resize(firstMesh + meshRuns.size());
+		std::vector<size_t> dropped(meshRuns.size());
+		JobSystem::GetInstance()->ParallelFor(meshRuns.size(), [&](size_t i)
+		{
+			dropped[i] = BuildMesh(chunks, chunkBases, meshRuns[i], meshBases[i], meshSizes[i], fileSize, cornerCounts[i], meshes[firstMesh + i]);
+		});
+
+		size_t droppedCount = 0;
+		for (size_t count : dropped)
+			droppedCount += count;
+		return droppedCount;
+	}
+
+	void LoadObj(const std::string& path, std::vector<Mesh>& meshes)
+	{
+		MappedFile file(path);
+		const char* begin = file.Data();
+		const char* end = begin + file.Size();
+
+		// Split the file into about one range of whole lines per thread, each is parsed on its own.
+		JobSystem* jobs = JobSystem::GetInstance();
+		size_t chunkCount = file.Size() / MIN_CHUNK_SIZE;
+		if (chunkCount > jobs->GetThreadCount()) chunkCount = jobs->GetThreadCount();
+		if (chunkCount < 1) chunkCount = 1;
+
+		std::vector<const char*> bounds(chunkCount + 1, end);
+		bounds[0] = begin;
+		for (size_t i = 1; i < chunkCount; i++)
+		{
+			const char* p = begin + file.Size() * i / chunkCount;
+			if (p < bounds[i - 1]) p = bounds[i - 1];
+			bounds[i] = p < end ? LineEnd(p, end) : end;
+			if (bounds[i] < end) bounds[i]++;
+		}
+
+		std::vector<ObjChunk> chunks(chunkCount);
+		jobs->ParallelFor(chunkCount, [&](size_t i) { ParseObjLines(bounds[i], bounds[i + 1], chunks[i]); });
+
+		size_t dropped = BuildMeshes(chunks, meshes);
+		if (dropped > 0)
+			std::cerr << "Skipped " << dropped << " triangles of " << path << " that use vertices the file doesn't have." << std::endl;
+	}
+}
@@ -0,0 +1,14 @@
+// Loads Wavefront OBJ files.
+#pragma once
+
+#include "../Model.h"
+#include <string>
+#include <vector>
+
+namespace MiniRenderer
+{
+	/// @brief Loads the Wavefront OBJ file at path & appends its meshes to meshes.
+	/// A new mesh starts at every group of v, vt & vn statements that follows faces. Polygons are split into triangles and
+	/// corners with the same position, texture coordinate & normal share one vertex.
+	void LoadObj(const std::string& path, std::vector<Mesh>& meshes);
+}
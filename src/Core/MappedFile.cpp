@@ -0,0 +1,89 @@
+#include "MappedFile.h"
+#include <stdexcept>
+
+#ifdef PLATFORM_WINDOWS
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace MiniRenderer
+{
+#ifdef PLATFORM_WINDOWS
+	MappedFile::MappedFile(const std::string& path)
+	{
+		m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (m_File == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("Failed to open file " + path + ".\n");
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_File, &size))
+		{
+			CloseHandle(m_File);
+			throw std::runtime_error("Failed to get the size of file " + path + ".\n");
+		}
+
+		m_Size = (size_t)size.QuadPart;
+		if (m_Size == 0) return;	// Empty files can't be mapped.
+
+		m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_Mapping != NULL)
+			m_Data = (const char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (m_Data == nullptr)
+		{
+			if (m_Mapping != NULL) CloseHandle(m_Mapping);
+			CloseHandle(m_File);
+			throw std::runtime_error("Failed to map file " + path + ".\n");
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_Data != nullptr) UnmapViewOfFile(m_Data);
+		if (m_Mapping != nullptr) CloseHandle(m_Mapping);
+		if (m_File != nullptr && m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+	}
+#else
+	MappedFile::MappedFile(const std::string& path)
+	{
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			throw std::runtime_error("Failed to open file " + path + ".\n");
+
+		struct stat status;
+		if (fstat(file, &status) != 0)
+		{
+			close(file);
+			throw std::runtime_error("Failed to get the size of file " + path + ".\n");
+		}
+
+		m_Size = (size_t)status.st_size;
+		if (m_Size > 0)
+		{
+			void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data == MAP_FAILED)
+			{
+				close(file);
+				throw std::runtime_error("Failed to map file " + path + ".\n");
+			}
+
+			// Files are read front to back, so let the kernel read ahead aggressively.
+			madvise(data, m_Size, MADV_SEQUENTIAL);
+			m_Data = (const char*)data;
+		}
+
+		// The mapping stays valid after the file is closed.
+		close(file);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_Data != nullptr)
+			munmap((void*)m_Data, m_Size);
+	}
+#endif
+}
@@ -0,0 +1,37 @@
+// Read only view of a whole file mapped into memory.
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace MiniRenderer
+{
+	/// @brief Maps a file into memory for reading, the mapping lives as long as this object.
+	class MappedFile
+	{
+	public:
+		/// @brief Maps the file at path, throws if it can't be opened or mapped.
+		MappedFile(const std::string& path);
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator =(const MappedFile&) = delete;
+
+		/// @brief First byte of the file, nullptr if the file is empty.
+		const char* Data() const { return m_Data; }
+
+		/// @brief Size of the file in bytes.
+		size_t Size() const { return m_Size; }
+	private:
+		/// @brief First byte of the mapping.
+		const char* m_Data = nullptr;
+
+		/// @brief Size of the mapping in bytes.
+		size_t m_Size = 0;
+
+#ifdef PLATFORM_WINDOWS
+		/// @brief Handles of the file & of its mapping.
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#endif
+	};
+}
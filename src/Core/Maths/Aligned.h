@@ -0,0 +1,83 @@
+#ifndef ALIGNED_H
+#define ALIGNED_H
+
+#include <stddef.h>
+#include <new>
+#include <vector>
+
+#if defined(PLATFORM_WINDOWS) || defined(_MSC_VER)
+	#include <malloc.h>
+#else
+	#include <stdlib.h>
+#endif
+
+namespace MiniRenderer
+{
+	/// @brief Alignment in bytes of SIMD types & of the memory AlignedAllocator hands out.
+	const size_t SIMD_ALIGNMENT = 32;
+
+	/// @brief Allocates size bytes aligned to alignment(a power of 2, at least sizeof(void*)), returns nullptr on failure.
+	inline void* AlignedAlloc(size_t size, size_t alignment)
+	{
+#if defined(PLATFORM_WINDOWS) || defined(_MSC_VER)
+		return _aligned_malloc(size, alignment);
+#else
+		void* memory = nullptr;
+		if (posix_memalign(&memory, alignment, size) != 0)
+			return nullptr;
+		return memory;
+#endif
+	}
+
+	/// @brief Frees memory returned by AlignedAlloc().
+	inline void AlignedFree(void* memory)
+	{
+#if defined(PLATFORM_WINDOWS) || defined(_MSC_VER)
+		_aligned_free(memory);
+#else
+		free(memory);
+#endif
+	}
+
+	/// @brief Same as AlignedAlloc() but throws std::bad_alloc on failure like operator new.
+	inline void* AlignedNew(size_t size, size_t alignment)
+	{
+		void* memory = AlignedAlloc(size, alignment);
+		if (memory == nullptr)
+			throw std::bad_alloc();
+		return memory;
+	}
+
+	/// @brief Allocator for standard containers of SIMD types, their storage is aligned to Alignment bytes on every platform.
+	template <class T, size_t Alignment = SIMD_ALIGNMENT>
+	class AlignedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template <class U>
+		struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+		AlignedAllocator() {}
+		template <class U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(AlignedNew(count * sizeof(T), Alignment));
+		}
+
+		void deallocate(T* memory, size_t) { AlignedFree(memory); }
+
+		template <class U>
+		bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+		template <class U>
+		bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+	};
+
+	/// @brief std::vector whose storage is aligned for SIMD loads & stores.
+	template <class T>
+	using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+}
+
+#endif // !ALIGNED_H
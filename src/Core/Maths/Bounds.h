@@ -0,0 +1,170 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "Vector.h"
+#include "Matrix.h"
+
+#include <math.h>
+
+namespace MiniRenderer
+{
+	/// @brief Axis aligned bounding box.
+	struct BoundingBox
+	{
+		Vec3f min, max;
+	};
+
+	/// @brief Bounding sphere.
+	struct BoundingSphere
+	{
+		Vec3f center;
+		float radius = 0.0f;
+	};
+
+	/// @brief The 6 planes of a view frustum(left, right, bottom, top, near, far), (x, y, z) being the unit normal
+	/// pointing inside & w the distance, so a point p is inside a plane if Dot(plane.xyz, p) + plane.w >= 0.
+	struct Frustum
+	{
+		Vec4f planes[6];
+	};
+
+	/// @brief Returns the smallest box holding the count points.
+	inline BoundingBox ComputeBoundingBox(const Vec3f* points, size_t count)
+	{
+		if (count == 0) return { Vec3f(), Vec3f() };
+
+		__m128 min = points[0]._mValue, max = points[0]._mValue;
+		for (size_t i = 1; i < count; i++)
+		{
+			min = _mm_min_ps(min, points[i]._mValue);
+			max = _mm_max_ps(max, points[i]._mValue);
+		}
+		return { Vec3f(min), Vec3f(max) };
+	}
+
+	/// @brief Returns the sphere around the center of box holding the count points.
+	inline BoundingSphere ComputeBoundingSphere(const BoundingBox& box, const Vec3f* points, size_t count)
+	{
+		Vec3f center = Vec3f(_mm_mul_ps(_mm_add_ps(box.min._mValue, box.max._mValue), _mm_set1_ps(0.5f)));
+		__m128 radiusSquared = _mm_setzero_ps();
+		for (size_t i = 0; i < count; i++)
+		{
+			__m128 offset = _mm_sub_ps(points[i]._mValue, center._mValue);
+			radiusSquared = _mm_max_ss(radiusSquared, _mm_dp_ps(offset, offset, 0x71));
+		}
+		return { center, sqrtf(_mm_cvtss_f32(radiusSquared)) };
+	}
+
+	/// @brief Returns the smallest box holding both boxes.
+	inline BoundingBox MergeBoxes(const BoundingBox& a, const BoundingBox& b)
+	{
+		return { Vec3f(_mm_min_ps(a.min._mValue, b.min._mValue)), Vec3f(_mm_max_ps(a.max._mValue, b.max._mValue)) };
+	}
+
+	/// @brief Returns half the surface area of the box, which is proportional to the chance of a random ray hitting it.
+	inline float HalfSurfaceArea(const BoundingBox& box)
+	{
+		Vec3f extent = box.max - box.min;
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+	/// @brief Returns the smallest axis aligned box holding box transformed by the affine matrix(Arvo).
+	inline BoundingBox TransformBox(const BoundingBox& box, const Mat4& matrix)
+	{
+		float center[3] = { (box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f };
+		float extent[3] = { (box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f, (box.max.z - box.min.z) * 0.5f };
+
+		float newCenter[3], newExtent[3];
+		for (int row = 0; row < 3; row++)
+		{
+			newCenter[row] = matrix(row, 3);
+			newExtent[row] = 0.0f;
+			for (int column = 0; column < 3; column++)
+			{
+				newCenter[row] += matrix(row, column) * center[column];
+				newExtent[row] += fabsf(matrix(row, column)) * extent[column];
+			}
+		}
+		return { Vec3f(newCenter[0] - newExtent[0], newCenter[1] - newExtent[1], newCenter[2] - newExtent[2]),
+				 Vec3f(newCenter[0] + newExtent[0], newCenter[1] + newExtent[1], newCenter[2] + newExtent[2]) };
+	}
+
+	/// @brief Returns if the ray origin + t * direction hits the box for some 0 <= t <= maxDistance, setting entry to the first such t.
+	/// Takes 1 / direction, which is infinite along axes the ray is parallel to.
+	inline bool IntersectRay(const BoundingBox& box, const Vec3f& origin, const Vec3f& inverseDirection, float maxDistance, float& entry)
+	{
+		__m128 t0 = _mm_mul_ps(_mm_sub_ps(box.min._mValue, origin._mValue), inverseDirection._mValue);
+		__m128 t1 = _mm_mul_ps(_mm_sub_ps(box.max._mValue, origin._mValue), inverseDirection._mValue);
+		Vec3f nearest(_mm_min_ps(t0, t1)), farthest(_mm_max_ps(t0, t1));
+
+		// NaN from 0 * infinity(the origin on a slab of a parallel axis) is dropped by fmax & fmin, leaving that axis unbounded.
+		float enter = fmaxf(fmaxf(fmaxf(nearest.x, nearest.y), nearest.z), 0.0f);
+		float exit = fminf(fminf(fminf(farthest.x, farthest.y), farthest.z), maxDistance);
+		entry = enter;
+		return enter <= exit;
+	}
+
+	/// @brief Extracts the frustum of the matrix(Gribb & Hartmann), for OpenGL style clip space where -w <= x, y, z <= w.
+	/// With a model-view-projection matrix the planes are in model space, so model space bounds can be tested without transforming them.
+	inline Frustum ExtractFrustum(const Mat4& matrix)
+	{
+		Vec4f rows[4];
+		for (int i = 0; i < 4; i++)
+			rows[i] = Vec4f(matrix(i, 0), matrix(i, 1), matrix(i, 2), matrix(i, 3));
+
+		Frustum frustum;
+		frustum.planes[0] = rows[3] + rows[0];
+		frustum.planes[1] = rows[3] - rows[0];
+		frustum.planes[2] = rows[3] + rows[1];
+		frustum.planes[3] = rows[3] - rows[1];
+		frustum.planes[4] = rows[3] + rows[2];
+		frustum.planes[5] = rows[3] - rows[2];
+
+		// Normalize the planes so that they give distances, which the sphere test needs.
+		for (Vec4f& plane : frustum.planes)
+		{
+			float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			if (length > 0.0f) plane *= 1.0f / length;
+		}
+		return frustum;
+	}
+
+	/// @brief Returns if the sphere lies entirely outside the frustum.
+	inline bool IsOutside(const Frustum& frustum, const BoundingSphere& sphere)
+	{
+		for (const Vec4f& plane : frustum.planes)
+			if (plane.x * sphere.center.x + plane.y * sphere.center.y + plane.z * sphere.center.z + plane.w < -sphere.radius)
+				return true;
+		return false;
+	}
+
+	/// @brief Returns if the box lies entirely outside the frustum, testing the corner furthest along every plane normal.
+	inline bool IsOutside(const Frustum& frustum, const BoundingBox& box)
+	{
+		for (const Vec4f& plane : frustum.planes)
+		{
+			float x = plane.x >= 0.0f ? box.max.x : box.min.x;
+			float y = plane.y >= 0.0f ? box.max.y : box.min.y;
+			float z = plane.z >= 0.0f ? box.max.z : box.min.z;
+			if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+				return true;
+		}
+		return false;
+	}
+
+	/// @brief Returns if the box lies entirely inside the frustum, testing the corner nearest along every plane normal.
+	inline bool IsInside(const Frustum& frustum, const BoundingBox& box)
+	{
+		for (const Vec4f& plane : frustum.planes)
+		{
+			float x = plane.x >= 0.0f ? box.min.x : box.max.x;
+			float y = plane.y >= 0.0f ? box.min.y : box.max.y;
+			float z = plane.z >= 0.0f ? box.min.z : box.max.z;
+			if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+				return false;
+		}
+		return true;
+	}
+}
+
+#endif // !BOUNDS_H
@@ -144,7 +144,7 @@ namespace MiniRenderer
 			return Vec3f(mult.x, mult.y, mult.z);
 		}
 
-		Vec4f operator*(Vec4f& v)
+		Vec4f operator*(const Vec4f& v) const
 		{
 			if (rows < 3) return v;
 
@@ -426,6 +426,59 @@ namespace MiniRenderer
 	typedef Matrix<4, 3> Mat4x3;
 	typedef Matrix<4, 4> Mat4;
 	typedef Matrix<4, 4> Mat4x4;
+
+	/// @brief Columns of a 4x4 matrix in SSE registers, for transforming many vectors by the same matrix.
+	/// Each product is the columns scaled by the vector & summed in order, so it matches Mat4 * Vec4f exactly.
+	struct Mat4Columns
+	{
+		explicit Mat4Columns(const Mat4& m)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				columns[j] = _mm_set_ps(m(3, j), m(2, j), m(1, j), m(0, j));
+				for (int i = 0; i < 4; i++)
+					elements[i][j] = _mm_set1_ps(m(i, j));
+			}
+		}
+
+		/// @brief Returns the matrix times v.
+		inline Vec4f Transform(const Vec4f& v) const
+		{
+			__m128 result = _mm_mul_ps(columns[0], _mm_shuffle_ps(v._mValue, v._mValue, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm_add_ps(result, _mm_mul_ps(columns[1], _mm_shuffle_ps(v._mValue, v._mValue, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm_add_ps(result, _mm_mul_ps(columns[2], _mm_shuffle_ps(v._mValue, v._mValue, _MM_SHUFFLE(2, 2, 2, 2))));
+			return _mm_add_ps(result, _mm_mul_ps(columns[3], _mm_shuffle_ps(v._mValue, v._mValue, _MM_SHUFFLE(3, 3, 3, 3))));
+		}
+
+		/// @brief Transforms the 4 points(w = 1) in p, writing the x, y, z & w of the results as SoA to clip.
+		inline void TransformPoints(const Vec3fx4& p, __m128 clip[4]) const
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				__m128 result = _mm_mul_ps(elements[i][0], p.x);
+				result = _mm_add_ps(result, _mm_mul_ps(elements[i][1], p.y));
+				result = _mm_add_ps(result, _mm_mul_ps(elements[i][2], p.z));
+				clip[i] = _mm_add_ps(result, elements[i][3]);
+			}
+		}
+
+		__m128 columns[4];
+		// Every element broadcast to all 4 lanes, for the SoA transforms.
+		__m128 elements[4][4];
+	};
+
+	template <>
+	inline Vec4f Matrix<4, 4>::operator*(const Vec4f& v) const
+	{
+		// Same sum of scaled columns as Mat4Columns::Transform, without broadcasting every element.
+		__m128 result = _mm_setzero_ps();
+		for (int j = 0; j < 4; j++)
+		{
+			__m128 column = _mm_set_ps(m_Buffer[3][j], m_Buffer[2][j], m_Buffer[1][j], m_Buffer[0][j]);
+			result = _mm_add_ps(result, _mm_mul_ps(column, _mm_set1_ps(v[j])));
+		}
+		return result;
+	}
 }
 
 #endif // !MATRIX_H
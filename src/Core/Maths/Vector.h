@@ -9,6 +9,11 @@
 
 #include <math.h>
 
+#include "Aligned.h"
+#ifdef __AVX2__
+	#include <immintrin.h>
+#endif
+
 namespace MiniRenderer
 {
 #pragma region Vector2
@@ -43,7 +48,7 @@ namespace MiniRenderer
 		inline const Vector2<T>& operator /=(const Vector2<T>& v) { assert(v.length() == 0.0f); x /= v.x; y /= v.y; return *this; }
 
 		// Subscript/Array Index Operator
-		inline T& operator[](int index) const { assert(index < 0 || index >= 2); return (&x)[index]; }
+		inline T& operator[](int index) const { assert(index >= 0 && index < 2); return (&x)[index]; }
 
 		/// @brief Returns the Length of this Vector2.
 		inline float length() const { return std::sqrt(x * x + y * y); }
@@ -137,7 +142,7 @@ namespace MiniRenderer
 		inline const Vec3i& operator/=(const Vec3i& b) { assert(b.length() == 0); _mValue = _mm_castps_si128(_mm_div_ps(_mm_castsi128_ps(_mValue), _mm_castsi128_ps(b._mValue))); return *this; }
 
 		// Subscript/Array Index Operator
-		inline int& operator[](int index) { assert(index < 0 || index >= 3); return (&x)[index]; }
+		inline int& operator[](int index) { assert(index >= 0 && index < 3); return (&x)[index]; }
 
 		// Returns the Length of this Vector.
 		inline float length() const { return _mm_cvtss_f32(_mm_sqrt_ss(_mm_dp_ps(_mm_castsi128_ps(_mValue), _mm_castsi128_ps(_mValue), 0x71))); }
@@ -158,10 +163,10 @@ namespace MiniRenderer
 		}
 
 		// Overload operators for enforcing correct alignment.
-#ifdef PLATFORM_WINDOWS
-		inline void* operator new[](size_t x) { return _aligned_malloc(x, 16); }
-		inline void operator delete[](void* x) { if (x) _aligned_free(x); }
-#endif
+		inline void* operator new(size_t x) { return AlignedNew(x, 16); }
+		inline void* operator new[](size_t x) { return AlignedNew(x, 16); }
+		inline void operator delete(void* x) { AlignedFree(x); }
+		inline void operator delete[](void* x) { AlignedFree(x); }
 		// Member Variables
 		union
 		{
@@ -248,8 +253,8 @@ namespace MiniRenderer
 		inline const Vec3f& operator/=(const Vec3f& b) { assert(b.length() != 0.0f); _mValue = _mm_div_ps(_mValue, b._mValue); return *this; }
 
 		// Subscript/Array Index Operator
-		inline float& operator[](int index) { assert(index > 0 || index < 3); return (&x)[index]; }
-		inline const float& operator[](int index) const { assert(index > 0 || index < 3); return (&x)[index]; }
+		inline float& operator[](int index) { assert(index >= 0 && index < 3); return (&x)[index]; }
+		inline const float& operator[](int index) const { assert(index >= 0 && index < 3); return (&x)[index]; }
 
 		// Returns the Length of this Vector.
 		inline float length() const { return _mm_cvtss_f32(_mm_sqrt_ss(_mm_dp_ps(_mValue, _mValue, 0x71))); }
@@ -266,10 +271,10 @@ namespace MiniRenderer
 		}
 
 		// Overload operators for enforcing correct alignment.
-#ifdef PLATFORM_WINDOWS
-		inline void* operator new[](size_t x) { return _aligned_malloc(x, 16); }
-		inline void operator delete[](void* x) { if (x) _aligned_free(x); }
-#endif
+		inline void* operator new(size_t x) { return AlignedNew(x, 16); }
+		inline void* operator new[](size_t x) { return AlignedNew(x, 16); }
+		inline void operator delete(void* x) { AlignedFree(x); }
+		inline void operator delete[](void* x) { AlignedFree(x); }
 		// Member Variables
 		union
 		{
@@ -351,7 +356,8 @@ namespace MiniRenderer
 		inline const Vec4f& operator/=(const Vec4f& b) { assert(b.length() != 0.0f); _mValue = _mm_div_ps(_mValue, b._mValue); return *this; }
 
 		// Subscript/Array Index Operator
-		inline float& operator[](int index) { assert(index > 0 || index < 4); return (&x)[index]; }
+		inline float& operator[](int index) { assert(index >= 0 && index < 4); return (&x)[index]; }
+		inline const float& operator[](int index) const { assert(index >= 0 && index < 4); return (&x)[index]; }
 
 		// Returns the Length of this Vector.
 		inline float length() const { return _mm_cvtss_f32(_mm_sqrt_ss(_mm_dp_ps(_mValue, _mValue, 0xF1))); }
@@ -368,10 +374,10 @@ namespace MiniRenderer
 		}
 
 		// Overload operators for enforcing correct alignment.
-#ifdef PLATFORM_WINDOWS
-		inline void* operator new[](size_t x) { return _aligned_malloc(x, 16); }
-		inline void operator delete[](void* x) { if (x) _aligned_free(x); }
-#endif
+		inline void* operator new(size_t x) { return AlignedNew(x, 16); }
+		inline void* operator new[](size_t x) { return AlignedNew(x, 16); }
+		inline void operator delete(void* x) { AlignedFree(x); }
+		inline void operator delete[](void* x) { AlignedFree(x); }
 
 			// Member Variables
 			union
@@ -399,6 +405,140 @@ namespace MiniRenderer
 	}
 
 #pragma endregion
+
+#pragma region Vec3fx4
+
+	// SoA packet of 4 Vector3 Floats, each member holds one axis of all 4 vectors.
+	// Processes 4 vectors per instruction where Vec3f wastes its w lane & needs horizontal adds.
+#ifdef __GNUC__
+	struct __attribute__((aligned(16))) Vec3fx4
+#else
+	_MM_ALIGN16 struct Vec3fx4		//__declspec(align(16))
+#endif
+	{
+		// Constructor
+		Vec3fx4() : x(_mm_setzero_ps()), y(_mm_setzero_ps()), z(_mm_setzero_ps()) {}
+		Vec3fx4(__m128 x, __m128 y, __m128 z) : x(x), y(y), z(z) {}
+		/// @brief Broadcasts v to all 4 lanes.
+		explicit Vec3fx4(const Vec3f& v) : x(_mm_set1_ps(v.x)), y(_mm_set1_ps(v.y)), z(_mm_set1_ps(v.z)) {}
+		/// @brief Transposes 4 vectors into a packet, a goes to lane 0.
+		Vec3fx4(const Vec3f& a, const Vec3f& b, const Vec3f& c, const Vec3f& d)
+		{
+			__m128 r0 = a._mValue, r1 = b._mValue, r2 = c._mValue, r3 = d._mValue;
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			x = r0; y = r1; z = r2;
+		}
+
+		// Arithmetic Operators with float
+		inline Vec3fx4 operator*(const float b) const { const __m128 s = _mm_set1_ps(b); return Vec3fx4(_mm_mul_ps(x, s), _mm_mul_ps(y, s), _mm_mul_ps(z, s)); }
+
+		// Arithmetic Operators, b may hold a different scale per lane.
+		inline Vec3fx4 operator*(const __m128 b) const { return Vec3fx4(_mm_mul_ps(x, b), _mm_mul_ps(y, b), _mm_mul_ps(z, b)); }
+		inline Vec3fx4 operator+(const Vec3fx4& b) const { return Vec3fx4(_mm_add_ps(x, b.x), _mm_add_ps(y, b.y), _mm_add_ps(z, b.z)); }
+		inline Vec3fx4 operator-(const Vec3fx4& b) const { return Vec3fx4(_mm_sub_ps(x, b.x), _mm_sub_ps(y, b.y), _mm_sub_ps(z, b.z)); }
+		inline Vec3fx4 operator*(const Vec3fx4& b) const { return Vec3fx4(_mm_mul_ps(x, b.x), _mm_mul_ps(y, b.y), _mm_mul_ps(z, b.z)); }
+
+		/// @brief Returns the vector in the given lane(0 to 3).
+		inline Vec3f lane(int index) const
+		{
+			assert(index >= 0 && index < 4);
+			alignas(16) float xs[4], ys[4], zs[4];
+			_mm_store_ps(xs, x); _mm_store_ps(ys, y); _mm_store_ps(zs, z);
+			return Vec3f(xs[index], ys[index], zs[index]);
+		}
+
+		inline void* operator new(size_t x) { return AlignedNew(x, 16); }
+		inline void* operator new[](size_t x) { return AlignedNew(x, 16); }
+		inline void operator delete(void* x) { AlignedFree(x); }
+		inline void operator delete[](void* x) { AlignedFree(x); }
+
+		// Member Variables
+		__m128 x, y, z;
+	};
+
+	/// @brief Returns the Dot Products of the 4 vector pairs in a & b.
+	inline __m128 Dot(const Vec3fx4& a, const Vec3fx4& b)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+	}
+
+	/// @brief Returns the Cross Products of the 4 vector pairs in a & b.
+	inline Vec3fx4 Cross(const Vec3fx4& a, const Vec3fx4& b)
+	{
+		return Vec3fx4(_mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)),
+					   _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)),
+					   _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x)));
+	}
+
+	/// @brief Returns the Lengths of the 4 vectors in v.
+	inline __m128 Length(const Vec3fx4& v) { return _mm_sqrt_ps(Dot(v, v)); }
+
+	/// @brief Returns the 4 vectors in v scaled to unit length.
+	inline Vec3fx4 Normalize(const Vec3fx4& v) { return v * _mm_rsqrt_ps(Dot(v, v)); }
+
+#pragma endregion
+
+#ifdef __AVX2__
+#pragma region Vec3fx8
+
+	// AVX2 SoA packet of 8 Vector3 Floats, each member holds one axis of all 8 vectors.
+#ifdef __GNUC__
+	struct __attribute__((aligned(32))) Vec3fx8
+#else
+	__declspec(align(32)) struct Vec3fx8
+#endif
+	{
+		// Constructor
+		Vec3fx8() : x(_mm256_setzero_ps()), y(_mm256_setzero_ps()), z(_mm256_setzero_ps()) {}
+		Vec3fx8(__m256 x, __m256 y, __m256 z) : x(x), y(y), z(z) {}
+		/// @brief Broadcasts v to all 8 lanes.
+		explicit Vec3fx8(const Vec3f& v) : x(_mm256_set1_ps(v.x)), y(_mm256_set1_ps(v.y)), z(_mm256_set1_ps(v.z)) {}
+		/// @brief Joins two packets, lo goes to lanes 0 to 3.
+		Vec3fx8(const Vec3fx4& lo, const Vec3fx4& hi)
+			: x(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.x), hi.x, 1)),
+			  y(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.y), hi.y, 1)),
+			  z(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.z), hi.z, 1)) {}
+
+		// Arithmetic Operators with float
+		inline Vec3fx8 operator*(const float b) const { const __m256 s = _mm256_set1_ps(b); return Vec3fx8(_mm256_mul_ps(x, s), _mm256_mul_ps(y, s), _mm256_mul_ps(z, s)); }
+
+		// Arithmetic Operators, b may hold a different scale per lane.
+		inline Vec3fx8 operator*(const __m256 b) const { return Vec3fx8(_mm256_mul_ps(x, b), _mm256_mul_ps(y, b), _mm256_mul_ps(z, b)); }
+		inline Vec3fx8 operator+(const Vec3fx8& b) const { return Vec3fx8(_mm256_add_ps(x, b.x), _mm256_add_ps(y, b.y), _mm256_add_ps(z, b.z)); }
+		inline Vec3fx8 operator-(const Vec3fx8& b) const { return Vec3fx8(_mm256_sub_ps(x, b.x), _mm256_sub_ps(y, b.y), _mm256_sub_ps(z, b.z)); }
+		inline Vec3fx8 operator*(const Vec3fx8& b) const { return Vec3fx8(_mm256_mul_ps(x, b.x), _mm256_mul_ps(y, b.y), _mm256_mul_ps(z, b.z)); }
+
+		inline void* operator new(size_t x) { return AlignedNew(x, 32); }
+		inline void* operator new[](size_t x) { return AlignedNew(x, 32); }
+		inline void operator delete(void* x) { AlignedFree(x); }
+		inline void operator delete[](void* x) { AlignedFree(x); }
+
+		// Member Variables
+		__m256 x, y, z;
+	};
+
+	/// @brief Returns the Dot Products of the 8 vector pairs in a & b.
+	inline __m256 Dot(const Vec3fx8& a, const Vec3fx8& b)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)), _mm256_mul_ps(a.z, b.z));
+	}
+
+	/// @brief Returns the Cross Products of the 8 vector pairs in a & b.
+	inline Vec3fx8 Cross(const Vec3fx8& a, const Vec3fx8& b)
+	{
+		return Vec3fx8(_mm256_sub_ps(_mm256_mul_ps(a.y, b.z), _mm256_mul_ps(a.z, b.y)),
+					   _mm256_sub_ps(_mm256_mul_ps(a.z, b.x), _mm256_mul_ps(a.x, b.z)),
+					   _mm256_sub_ps(_mm256_mul_ps(a.x, b.y), _mm256_mul_ps(a.y, b.x)));
+	}
+
+	/// @brief Returns the Lengths of the 8 vectors in v.
+	inline __m256 Length(const Vec3fx8& v) { return _mm256_sqrt_ps(Dot(v, v)); }
+
+	/// @brief Returns the 8 vectors in v scaled to unit length.
+	inline Vec3fx8 Normalize(const Vec3fx8& v) { return v * _mm256_rsqrt_ps(Dot(v, v)); }
+
+#pragma endregion
+#endif
 }
 
 #endif // VECTOR_H
\ No newline at end of file
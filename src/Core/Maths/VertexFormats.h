@@ -0,0 +1,109 @@
+#ifndef VERTEX_FORMATS_H
+#define VERTEX_FORMATS_H
+
+#include "Vector.h"
+
+#include <stdint.h>
+#include <string.h>
+
+namespace MiniRenderer
+{
+	/// @brief Position quantized to 16 bits per axis inside the bounds of its mesh, see DecodePosition.
+	/// w is unused, it keeps every position a single 8 byte load.
+	struct QuantizedPosition
+	{
+		uint16_t x, y, z, w;
+	};
+
+	/// @brief Unit vector folded onto an octahedron & stored as 2 signed normalized 16 bit values.
+	struct OctNormal
+	{
+		int16_t x, y;
+	};
+
+	/// @brief Texture coordinate stored as 2 IEEE half precision floats.
+	struct HalfTexcoord
+	{
+		uint16_t u, v;
+	};
+
+#pragma region Encoding
+	/// @brief Quantizes the position inside the bounds starting at offset, scale being the size of the bounds divided by 65535.
+	inline QuantizedPosition EncodePosition(const Vec3f& position, const Vec3f& offset, const Vec3f& scale)
+	{
+		float p[3] = { position.x, position.y, position.z }, o[3] = { offset.x, offset.y, offset.z }, s[3] = { scale.x, scale.y, scale.z };
+		uint16_t q[3];
+		for (int i = 0; i < 3; i++)
+		{
+			float value = s[i] > 0.0f ? (p[i] - o[i]) / s[i] + 0.5f : 0.0f;
+			q[i] = (uint16_t)(value <= 0.0f ? 0.0f : (value >= 65535.0f ? 65535.0f : value));
+		}
+		return { q[0], q[1], q[2], 0 };
+	}
+
+	/// @brief Encodes the unit vector as an octahedral normal.
+	inline OctNormal EncodeNormal(const Vec3f& normal)
+	{
+		float x = normal.x, y = normal.y, z = normal.z;
+		float sum = fabsf(x) + fabsf(y) + fabsf(z);
+		if (sum == 0.0f) return { 0, 0 };
+		x /= sum;
+		y /= sum;
+
+		// Fold the lower half of the octahedron over the upper one.
+		if (z < 0.0f)
+		{
+			float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = foldedX;
+			y = foldedY;
+		}
+		return { (int16_t)lrintf(x * 32767.0f), (int16_t)lrintf(y * 32767.0f) };
+	}
+
+	/// @brief Converts the float to the nearest half precision float, ties to even.
+	inline uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+		uint32_t magnitude = bits & 0x7FFFFFFF;
+
+		if (magnitude >= 0x7F800000)
+			return sign | (magnitude > 0x7F800000 ? 0x7E00 : 0x7C00);	// NaN or infinity.
+		if (magnitude >= 0x477FF000)
+			return sign | 0x7C00;	// Rounds to more than the largest half.
+
+		if (magnitude < 0x38800000)
+		{
+			// Denormal half, adding 0.5 lets the float unit do the rounding.
+			float denormal;
+			uint32_t magnitudeBits = magnitude;
+			memcpy(&denormal, &magnitudeBits, sizeof(denormal));
+			denormal += 0.5f;
+			memcpy(&magnitudeBits, &denormal, sizeof(magnitudeBits));
+			return sign | (uint16_t)(magnitudeBits - 0x3F000000);
+		}
+
+		uint32_t oddMantissa = (magnitude >> 13) & 1;
+		magnitude += 0xC8000FFF + oddMantissa;	// Rebias the exponent & round to nearest even.
+		return sign | (uint16_t)(magnitude >> 13);
+	}
+
+	inline HalfTexcoord EncodeTexcoord(const Vec2f& texcoord)
+	{
+		return { FloatToHalf(texcoord.x), FloatToHalf(texcoord.y) };
+	}
+#pragma endregion
+
+#pragma region Decoding
+	/// @brief Returns the position quantized by EncodePosition with the same offset & scale.
+	inline Vec3f DecodePosition(const QuantizedPosition& position, const Vec3f& offset, const Vec3f& scale)
+	{
+		__m128i q = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&position)));
+		return _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(q), scale._mValue), offset._mValue);
+	}
+#pragma endregion
+}
+
+#endif
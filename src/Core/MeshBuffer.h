@@ -0,0 +1,52 @@
+// Array of mesh data that either owns its values or views them inside a mapped file.
+#pragma once
+
+#include "MappedFile.h"
+#include <vector>
+#include <memory>
+
+namespace MiniRenderer
+{
+	/// @brief Array of mesh data, owned in a vector or viewed in place inside a mapped file(e.g. a mesh cache).
+	/// Copies of a view share the mapping, which stays alive as long as any of them does.
+	template <typename T>
+	class MeshBuffer
+	{
+	public:
+		MeshBuffer() {}
+		MeshBuffer(std::vector<T> values) : m_Values(std::move(values)) {}
+
+		/// @brief Views count values at data, which has to point inside file.
+		MeshBuffer(std::shared_ptr<const MappedFile> file, const T* data, size_t count) : m_File(std::move(file)), m_View(data), m_ViewSize(count) {}
+
+		const T* data() const { return m_File ? m_View : m_Values.data(); }
+		size_t size() const { return m_File ? m_ViewSize : m_Values.size(); }
+		bool empty() const { return size() == 0; }
+
+		const T& operator [](size_t index) const { return data()[index]; }
+		const T* begin() const { return data(); }
+		const T* end() const { return data() + size(); }
+
+		/// @brief Returns if the values are viewed inside a mapped file.
+		bool IsView() const { return m_File != nullptr; }
+
+		/// @brief Returns the values for editing, a view is copied into owned memory first.
+		std::vector<T>& Edit()
+		{
+			if (m_File)
+			{
+				m_Values.assign(m_View, m_View + m_ViewSize);
+				m_File.reset();
+				m_View = nullptr;
+				m_ViewSize = 0;
+			}
+			return m_Values;
+		}
+	private:
+		std::vector<T> m_Values;
+
+		std::shared_ptr<const MappedFile> m_File;
+		const T* m_View = nullptr;
+		size_t m_ViewSize = 0;
+	};
+}
@@ -1,153 +1,462 @@
 #include "Model.h"
 #include "LineRenderer.h"
 #include "TriangleRenderer.h"
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include "Loaders/ObjLoader.h"
+#include "Loaders/MeshCache.h"
+#include "Loaders/MeshOptimizer.h"
+#include "Loaders/GltfLoader.h"
+#include "JobSystem.h"
+#include "OcclusionBuffer.h"
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
 
 namespace MiniRenderer
 {
-	Model::Model(const std::string path)
+	/// @brief Number of visible clusters from which their vertices are transformed on all threads.
+	static const size_t PARALLEL_CLUSTER_COUNT = 64;
+
+	/// @brief Largest error in pixels a level of detail may have on screen to be drawn.
+	static const float LOD_PIXEL_ERROR = 1.0f;
+
+	/// @brief Fraction of LOD_PIXEL_ERROR a coarser level of detail has to be under before switching to it,
+	/// so that an instance at the switching distance doesn't switch back & forth.
+	static const float LOD_HYSTERESIS = 0.25f;
+
+	Model::Model(const std::string path, bool compressVertices)
 	{
-		LoadMesh(path);
+		LoadMesh(path, compressVertices);
 	}
 
-	void Model::DrawWireframe(Framebuffer& buffer, uint32_t meshIndex, uint32_t color)
+	void Model::DrawWireframe(Framebuffer& buffer, Camera& camera, Mat4& modelMatrix, uint32_t meshIndex, uint32_t color, bool antialiased)
 	{
 		if (meshes.size() < meshIndex + 1) return;
 
+		const Mesh& mesh = meshes[meshIndex];
+		int bufferWidth = buffer.GetFramebufferWidth();
+		int bufferHeight = buffer.GetFramebufferHeight();
+
+		Mat4 projectionMatrix = camera.GetProjectionMatrix((float)bufferWidth / (float)bufferHeight), viewMatrix = camera.GetViewMatrix();
+		Mat4 viewProjection = projectionMatrix * viewMatrix;
+		Mat4 modelViewProjection = viewProjection * modelMatrix;
+
+		if (mesh.nFaces == 0) return;
+		if (mesh.faceNormalsX.size() < mesh.faces.size() / 3)
+			ComputeNormals(meshes[meshIndex]);
+		if (mesh.clusters.empty())
+			ComputeBounds(meshes[meshIndex]);
+		if (mesh.edges.empty())
+			ComputeEdges(meshes[meshIndex]);
+
+		Frustum frustum = ExtractFrustum(modelViewProjection);
+		if (IsOutside(frustum, mesh.sphere) || IsOutside(frustum, mesh.box))
+			return;
+
+		// Transform every vertex once, however many edges share it. Vertices behind the near plane(z < -w) can't be projected.
+		m_ClipVertices.resize(mesh.nVertices);
+		if (antialiased)
+			m_LinePoints.resize(mesh.nVertices);
+		else
+			m_LineVertices.resize(mesh.nVertices);
+		const Mat4Columns transform(modelViewProjection);
+		bool behindNearPlane = false;
+		for (uint32_t vertex = 0; vertex < mesh.nVertices; vertex++)
+		{
+			Vec3f position = mesh.GetVertex(vertex);
+			m_ClipVertices[vertex] = transform.Transform(Vec4f(position.x, position.y, position.z, 1.0f));
+			if (m_ClipVertices[vertex].z + m_ClipVertices[vertex].w < 0.0f)
+				behindNearPlane = true;
+			else if (antialiased)
+				m_LinePoints[vertex] = ProjectPoint(m_ClipVertices[vertex], bufferWidth, bufferHeight);
+			else
+				m_LineVertices[vertex] = ProjectVertex(m_ClipVertices[vertex], bufferWidth, bufferHeight);
+		}
+
+		const size_t edgeCount = mesh.edges.size() / 2;
+		if (!behindNearPlane)
+		{
+			if (antialiased)
+				DrawLinesAntialiased(m_LinePoints.data(), mesh.edges.data(), edgeCount, color, buffer);
+			else
+				DrawLines(m_LineVertices.data(), mesh.edges.data(), edgeCount, color, buffer);
+			return;
+		}
+
+		// Draw the edges in front of the near plane together, & cut those crossing it where they cross.
+		m_LineEdges.clear();
+		for (size_t edge = 0; edge < edgeCount; edge++)
+		{
+			uint32_t a = mesh.edges[edge * 2], b = mesh.edges[edge * 2 + 1];
+			const Vec4f& c0 = m_ClipVertices[a];
+			const Vec4f& c1 = m_ClipVertices[b];
+			float d0 = c0.z + c0.w, d1 = c1.z + c1.w;
+			if (d0 >= 0.0f && d1 >= 0.0f)
+			{
+				m_LineEdges.push_back(a);
+				m_LineEdges.push_back(b);
+			}
+			else if (d0 >= 0.0f || d1 >= 0.0f)
+			{
+				float t = d0 / (d0 - d1);
+				Vec4f cut(c0.x + (c1.x - c0.x) * t, c0.y + (c1.y - c0.y) * t, c0.z + (c1.z - c0.z) * t, c0.w + (c1.w - c0.w) * t);
+				uint32_t front = d0 >= 0.0f ? a : b;
+				if (antialiased)
+				{
+					Vec2f end = ProjectPoint(cut, bufferWidth, bufferHeight);
+					DrawLineAntialiased(m_LinePoints[front].x, m_LinePoints[front].y, end.x, end.y, color, buffer);
+				}
+				else
+				{
+					Vec2i end = ProjectVertex(cut, bufferWidth, bufferHeight);
+					DrawLine(m_LineVertices[front].x, m_LineVertices[front].y, end.x, end.y, color, buffer);
+				}
+			}
+		}
+		if (antialiased)
+			DrawLinesAntialiased(m_LinePoints.data(), m_LineEdges.data(), m_LineEdges.size() / 2, color, buffer);
+		else
+			DrawLines(m_LineVertices.data(), m_LineEdges.data(), m_LineEdges.size() / 2, color, buffer);
+	}
+
+	void Model::Draw(Framebuffer& buffer, Camera& camera, Mat4& modelMatrix, uint32_t meshIndex, uint32_t color)
+	{
+		DrawInstances(buffer, camera, &modelMatrix, &color, 1, meshIndex);
+	}
+
+	void Model::DrawInstances(Framebuffer& buffer, Camera& camera, Mat4* modelMatrices, const uint32_t* colors, size_t instanceCount, uint32_t meshIndex, const OcclusionBuffer* occlusion, uint8_t* lodLevels, const uint32_t* instances)
+	{
+		if (meshes.size() < meshIndex + 1 || instanceCount == 0) return;
+
+		const Mesh& mesh = meshes[meshIndex];
 		int bufferWidth = buffer.GetFramebufferWidth();
 		int bufferHeight = buffer.GetFramebufferHeight();
+		//printf("Number of Faces: %d\tNumber of Vertices: %d\n", mesh.nFaces, mesh.nVertices);
 
-		Mat4 modelMatrix, projectionMatrix;
+		Mat4 projectionMatrix = camera.GetProjectionMatrix((float)bufferWidth / (float)bufferHeight), viewMatrix = camera.GetViewMatrix();
+
+		Mat4 viewProjection = projectionMatrix * viewMatrix;
 		
-		for (uint32_t i = 0; i < meshes[meshIndex].nFaces / 3; i++)
+		Vec3f lightDirection(0.2f, 0.3f, 1.0f);
+		lightDirection.normalize();
+
+		// Everything that doesn't depend on the instance is done once for the whole batch: face normals & bounds.
+		const uint32_t triangleCount = (uint32_t)(mesh.faces.size() / 3);
+		if (mesh.faceNormalsX.size() < triangleCount)
+			ComputeNormals(meshes[meshIndex]);
+		if (mesh.clusters.empty() && triangleCount > 0)
+			ComputeBounds(meshes[meshIndex]);
+		m_FaceIntensities.resize(triangleCount);
+		m_ScreenVertices.resize(mesh.clusterVertices.size());
+
+		const Vec3f cameraPosition = camera.Position;
+
+		// Pixels covered by a length of 1 in front of the camera at a distance of 1.
+		const float pixelsPerUnit = std::fabs(projectionMatrix(1, 1)) * bufferHeight * 0.5f;
+
+		for (size_t copy = 0; copy < instanceCount; copy++)
 		{
-			for (uint32_t j = 0; j < 3; j++)
+			const size_t instance = instances != nullptr ? instances[copy] : copy;
+			Mat4& modelMatrix = modelMatrices[instance];
+			Mat4 modelViewProjection = viewProjection * modelMatrix;
+			const uint32_t color = colors[instance];
+
+			// Skip the instance before touching any vertex if it lies outside the view. The frustum of the model-view-projection
+			// matrix is in model space, so the bounds of the mesh are tested as they are.
+			Frustum frustum = ExtractFrustum(modelViewProjection);
+			if (IsOutside(frustum, mesh.sphere) || IsOutside(frustum, mesh.box))
+				continue;
+			if (occlusion != nullptr && !occlusion->IsVisible(mesh.box, modelViewProjection))
+				continue;
+			const bool meshInside = IsInside(frustum, mesh.box);
+
+			// Pick the level of detail from the size of its error on screen, where the mesh is nearest to the camera.
+			uint32_t firstCluster = 0, clusterCount = (uint32_t)mesh.clusters.size();
+			if (mesh.lods.size() > 1)
 			{
-				Vec3f v0 = meshes[meshIndex].vertices[meshes[meshIndex].faces[i * 3 + j] - 1];
-				Vec3f v1 = meshes[meshIndex].vertices[meshes[meshIndex].faces[i * 3 + (j + 1) % 3] - 1];
+				// Errors grow with the largest scale of the model matrix.
+				float scale = 0.0f;
+				for (int column = 0; column < 3; column++)
+					scale = std::max(scale, modelMatrix(0, column) * modelMatrix(0, column) + modelMatrix(1, column) * modelMatrix(1, column) + modelMatrix(2, column) * modelMatrix(2, column));
+				scale = std::sqrt(scale);
+
+				const Vec3f& center = mesh.sphere.center;
+				float depth = modelViewProjection(3, 0) * center.x + modelViewProjection(3, 1) * center.y + modelViewProjection(3, 2) * center.z + modelViewProjection(3, 3);
+				float distance = std::max(depth - mesh.sphere.radius * scale, NEAR_PLANE);
+				float errorScale = scale * pixelsPerUnit / distance;
+
+				uint32_t lod = std::min<uint32_t>(lodLevels != nullptr ? lodLevels[instance] : 0, (uint32_t)mesh.lods.size() - 1);
+				while (lod > 0 && mesh.lods[lod].error * errorScale > LOD_PIXEL_ERROR)
+					lod--;
+				while (lod + 1 < mesh.lods.size() && mesh.lods[lod + 1].error * errorScale <= LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS))
+					lod++;
+				if (lodLevels != nullptr)
+					lodLevels[instance] = (uint8_t)lod;
+
+				firstCluster = mesh.lods[lod].firstCluster;
+				clusterCount = mesh.lods[lod].clusterCount;
+			}
 
-				modelMatrix.Identity();
+			// Normals transform with the cofactor matrix of the upper 3x3 of the model matrix, which keeps them perpendicular
+			// to the transformed triangles(Cross(M * a, M * b) = cofactor(M) * Cross(a, b)) & needs no inverse.
+			Vec3f rows[3] = { Vec3f(modelMatrix(0, 0), modelMatrix(0, 1), modelMatrix(0, 2)),
+							  Vec3f(modelMatrix(1, 0), modelMatrix(1, 1), modelMatrix(1, 2)),
+							  Vec3f(modelMatrix(2, 0), modelMatrix(2, 1), modelMatrix(2, 2)) };
+			Vec3f normalMatrix[3] = { Cross(rows[1], rows[2]), Cross(rows[2], rows[0]), Cross(rows[0], rows[1]) };
+
+			// Whether a triangle faces the camera doesn't change under an affine transform that keeps the winding, so the cones
+			// are tested against the camera position brought into model space: inverse(M) * p = transpose(cofactor(M)) * p / det(M).
+			const float determinant = Dot(rows[0], normalMatrix[0]);
+			const bool coneCulling = determinant > 0.0f;
+			Vec3f eye;
+			if (coneCulling)
+			{
+				Vec3f offset = cameraPosition - Vec3f(modelMatrix(0, 3), modelMatrix(1, 3), modelMatrix(2, 3));
+				eye = (normalMatrix[0] * offset.x + normalMatrix[1] * offset.y + normalMatrix[2] * offset.z) * (1.0f / determinant);
+			}
 
-				Scale(modelMatrix, Vec3f(1.5f, 2.5f, 1.5f));
-				//Rotate(modelMatrix, ToRadians(-10.0f), Vec3f(0.0f, 0.0f, 1.0f));
-				Rotate(modelMatrix, ToRadians(20.0f), Vec3f(1.0f, 0.0f, 0.0f));
-				Rotate(modelMatrix, ToRadians(60.0f), Vec3f(0.0f, 1.0f, 0.0f));
-				Translate(modelMatrix, Vec3f(0.0f, 0.0f, 10.0f));
+			m_VisibleClusters.clear();
+			for (uint32_t i = firstCluster; i < firstCluster + clusterCount; i++)
+			{
+				const MeshCluster& cluster = mesh.clusters[i];
 
-				Perspective(projectionMatrix, 60.0f, (float)bufferWidth / (float)bufferHeight, 0.1f, 100.0f);
-				//Orthographic(projectionMatrix, 10.0f, -10.0f, 10.0f, -10.0f, 0.01f, 20.0f);
+				// Clusters whose every triangle faces away from the camera.
+				if (coneCulling)
+				{
+					Vec3f toCluster = cluster.sphere.center - eye;
+					if (Dot(toCluster, cluster.coneAxis) >= cluster.coneCutoff * toCluster.length() + cluster.sphere.radius)
+						continue;
+				}
 
-				v0 = projectionMatrix * modelMatrix * v0;
-				v1 = projectionMatrix * modelMatrix * v1;
+				// Clusters only need testing against the frustum if the mesh crosses it.
+				if (!meshInside && (IsOutside(frustum, cluster.sphere) || IsOutside(frustum, cluster.box)))
+					continue;
 
-				v0.x = (int)((v0.x + 1) * bufferWidth / 2);
-				v0.y = (int)((v0.y + 1) * bufferHeight / 2);
-				
-				v1.x = (int)((v1.x + 1) * bufferWidth / 2);
-				v1.y = (int)((v1.y + 1) * bufferHeight / 2);
+				// Clusters hidden behind the occluders, tested last as it is the most expensive.
+				if (occlusion != nullptr && !occlusion->IsVisible(cluster.box, modelViewProjection))
+					continue;
 
-				DrawLine(v0.x, v0.y, v1.x, v1.y, color, buffer);
+				m_VisibleClusters.push_back(i);
+			}
+
+			// Transform the vertices & light the faces of every visible cluster, which are independent of each other.
+			const Mat4Columns transform(modelViewProjection);
+			auto prepareCluster = [&](size_t visibleCluster)
+			{
+				const MeshCluster& cluster = mesh.clusters[m_VisibleClusters[visibleCluster]];
+				TransformVertices(mesh, mesh.clusterVertices.data() + cluster.firstVertex, cluster.vertexCount, transform,
+								  bufferWidth, bufferHeight, m_ScreenVertices.data() + cluster.firstVertex);
+
+				// Flat Shading, lighting every face of the cluster from its precomputed normal.
+				ShadeFaces(mesh, cluster.firstTriangle, cluster.triangleCount, normalMatrix, lightDirection, m_FaceIntensities.data());
+			};
+			if (m_VisibleClusters.size() >= PARALLEL_CLUSTER_COUNT)
+				JobSystem::GetInstance()->ParallelFor(m_VisibleClusters.size(), prepareCluster);
+			else
+				for (size_t i = 0; i < m_VisibleClusters.size(); i++)
+					prepareCluster(i);
+
+			// Rasterize in order, so the image doesn't depend on how the clusters were spread over the threads.
+			Vec2i triangle[3];
+			for (uint32_t clusterIndex : m_VisibleClusters)
+			{
+				const MeshCluster& cluster = mesh.clusters[clusterIndex];
+				const Vec2i* screenVertices = m_ScreenVertices.data() + cluster.firstVertex;
+
+				const uint32_t lastTriangle = cluster.firstTriangle + cluster.triangleCount;
+				for (uint32_t i = cluster.firstTriangle; i < lastTriangle; i++)
+				{
+					triangle[0] = screenVertices[mesh.clusterIndices[i * 3]];
+					triangle[1] = screenVertices[mesh.clusterIndices[i * 3 + 1]];
+					triangle[2] = screenVertices[mesh.clusterIndices[i * 3 + 2]];
+
+					float intensity = m_FaceIntensities[i];
+
+					uint32_t red = ((color >> 16) & 0xFF) * intensity;
+					uint32_t green = ((color >> 8) & 0xFF) * intensity;
+					uint32_t blue = (color & 0xFF) * intensity;
+
+					uint32_t col = (red << 16) + (green << 8) + blue;
+
+					DrawTriangle(triangle, col, buffer);
+				}
 			}
 		}
 	}
 
-	void Model::Draw(Framebuffer& buffer, Camera& camera, uint32_t meshIndex, uint32_t color)
+	bool Model::Intersect(const Vec3f& origin, const Vec3f& direction, float& distance) const
 	{
-		if (meshes.size() < meshIndex + 1) return;
+		const Vec3f inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+		bool hit = false;
+		float entry;
+		for (const Mesh& mesh : meshes)
+		{
+			if (!IntersectRay(mesh.box, origin, inverseDirection, distance, entry)) continue;
 
-		int bufferWidth = buffer.GetFramebufferWidth();
-		int bufferHeight = buffer.GetFramebufferHeight();
-		//printf("Number of Faces: %d\tNumber of Vertices: %d\n", meshes[meshIndex].nFaces, meshes[meshIndex].nVertices);
+			const uint32_t firstCluster = mesh.lods.empty() ? 0 : mesh.lods[0].firstCluster;
+			const uint32_t clusterCount = mesh.lods.empty() ? (uint32_t)mesh.clusters.size() : mesh.lods[0].clusterCount;
+			for (uint32_t c = firstCluster; c < firstCluster + clusterCount; c++)
+			{
+				const MeshCluster& cluster = mesh.clusters[c];
+				if (!IntersectRay(cluster.box, origin, inverseDirection, distance, entry)) continue;
 
-		Mat4 modelMatrix, projectionMatrix, viewMatrix = camera.GetViewMatrix();
-		
-		Vec3f lightDirection(0.2f, 0.3f, 1.0f);
-		lightDirection.normalize();
+				// Moller & Trumbore, hitting triangles from either side.
+				for (uint32_t i = cluster.firstTriangle; i < cluster.firstTriangle + cluster.triangleCount; i++)
+				{
+					Vec3f p0 = mesh.GetVertex(mesh.clusterVertices[cluster.firstVertex + mesh.clusterIndices[i * 3]]);
+					Vec3f edge1 = mesh.GetVertex(mesh.clusterVertices[cluster.firstVertex + mesh.clusterIndices[i * 3 + 1]]) - p0;
+					Vec3f edge2 = mesh.GetVertex(mesh.clusterVertices[cluster.firstVertex + mesh.clusterIndices[i * 3 + 2]]) - p0;
+
+					Vec3f p = Cross(direction, edge2);
+					float determinant = Dot(edge1, p);
+					if (determinant == 0.0f) continue;
+					float inverseDeterminant = 1.0f / determinant;
+
+					Vec3f offset = origin - p0;
+					float u = Dot(offset, p) * inverseDeterminant;
+					if (u < 0.0f || u > 1.0f) continue;
+					Vec3f q = Cross(offset, edge1);
+					float v = Dot(direction, q) * inverseDeterminant;
+					if (v < 0.0f || u + v > 1.0f) continue;
+
+					float t = Dot(edge2, q) * inverseDeterminant;
+					if (t >= 0.0f && t <= distance)
+					{
+						distance = t;
+						hit = true;
+					}
+				}
+			}
+		}
+		return hit;
+	}
+
+	/// @brief Returns the lighting of 4 faces with the normals (x, y, z), transformed by normalMatrix, clamped to [0, 1].
+	static inline __m128 ShadeFaces4(__m128 x, __m128 y, __m128 z, const __m128 matrix[9], const __m128 light[3])
+	{
+		__m128 nx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[0], x), _mm_mul_ps(matrix[1], y)), _mm_mul_ps(matrix[2], z));
+		__m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[3], x), _mm_mul_ps(matrix[4], y)), _mm_mul_ps(matrix[5], z));
+		__m128 nz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[6], x), _mm_mul_ps(matrix[7], y)), _mm_mul_ps(matrix[8], z));
 
-		Vec2i triangle[3];
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, light[0]), _mm_mul_ps(ny, light[1])), _mm_mul_ps(nz, light[2]));
+
+		// rsqrt refined by one Newton-Raphson step, degenerate faces give NaN which the max turns into 0.
+		__m128 inverseLength = _mm_rsqrt_ps(lengthSquared);
+		inverseLength = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), inverseLength),
+								   _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(lengthSquared, inverseLength), inverseLength)));
+
+		__m128 intensity = _mm_mul_ps(dot, inverseLength);
+		return _mm_min_ps(_mm_max_ps(intensity, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	}
 
-		for (uint32_t i = 0; i < meshes[meshIndex].nFaces / 3; i++)
+	void Model::ShadeFaces(const Mesh& mesh, uint32_t firstTriangle, uint32_t triangleCount, const Vec3f normalMatrix[3], const Vec3f& lightDirection, float* intensities)
+	{
+		const __m128 matrix[9] = { _mm_set1_ps(normalMatrix[0].x), _mm_set1_ps(normalMatrix[0].y), _mm_set1_ps(normalMatrix[0].z),
+								   _mm_set1_ps(normalMatrix[1].x), _mm_set1_ps(normalMatrix[1].y), _mm_set1_ps(normalMatrix[1].z),
+								   _mm_set1_ps(normalMatrix[2].x), _mm_set1_ps(normalMatrix[2].y), _mm_set1_ps(normalMatrix[2].z) };
+		const __m128 light[3] = { _mm_set1_ps(lightDirection.x), _mm_set1_ps(lightDirection.y), _mm_set1_ps(lightDirection.z) };
+
+		const size_t count = triangleCount;
+		const float* x = mesh.faceNormalsX.data() + firstTriangle;
+		const float* y = mesh.faceNormalsY.data() + firstTriangle;
+		const float* z = mesh.faceNormalsZ.data() + firstTriangle;
+		intensities += firstTriangle;
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(intensities + i, ShadeFaces4(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i), _mm_loadu_ps(z + i), matrix, light));
+
+		if (i < count)
 		{
-			for (uint32_t j = 0; j < 3; j++)
+			// Pad the last faces with zero normals.
+			alignas(16) float tailX[4] = {}, tailY[4] = {}, tailZ[4] = {}, tail[4];
+			for (size_t j = 0; i + j < count; j++)
 			{
-				Vec3f rawV0 = meshes[meshIndex].vertices[meshes[meshIndex].faces[i * 3 + j] - 1];
-				Vec3f rawV1 = meshes[meshIndex].vertices[meshes[meshIndex].faces[i * 3 + (j + 1) % 3] - 1];
-				Vec3f rawV2 = meshes[meshIndex].vertices[meshes[meshIndex].faces[i * 3 + (j + 2) % 3] - 1];
-
-				Vec4f v0 = Vec4f(rawV0.x, rawV0.y, rawV0.z, 1.0f);
-				Vec4f v1 = Vec4f(rawV1.x, rawV1.y, rawV1.z, 1.0f);
-				Vec4f v2 = Vec4f(rawV2.x, rawV2.y, rawV2.z, 1.0f);
-
-				modelMatrix.Identity();
-				projectionMatrix.Identity();
-
-				Scale(modelMatrix, Vec3f(1.5f, 2.5f, 1.5f));
-				Rotate(modelMatrix, ToRadians(-10.0f), Vec3f(0.0f, 0.0f, 1.0f));
-				Rotate(modelMatrix, ToRadians(20.0f), Vec3f(1.0f, 0.0f, 0.0f));
-				Rotate(modelMatrix, ToRadians(45.0f), Vec3f(0.0f, 1.0f, 0.0f));
-				Translate(modelMatrix, Vec3f(0.0f, 1.0f, -4.0f));
-
-				Perspective(projectionMatrix, 45.0f, (float)bufferWidth / (float)bufferHeight, 0.1f, 100.0f);
-				//Orthographic(projectionMatrix, 10.0f, -10.0f, 10.0f, -10.0f, 0.01f, 20.0f);
-
-				v0 = modelMatrix * v0;
-				v1 = modelMatrix * v1;
-				v2 = modelMatrix * v2;
-
-				// Get Normal
-				Vec4f v2minuxv0 = v2 - v0;
-				Vec3f v2v0 = Vec3f(v2minuxv0.x, v2minuxv0.y, v2minuxv0.z);
-				Vec4f v1minuxv0 = v1 - v0;
-				Vec3f v1v0 = Vec3f(v1minuxv0.x, v1minuxv0.y, v1minuxv0.z);
-				Vec3f normal = Cross(v2v0, v1v0);
-				normal.normalize();
-
-				// Flat Shading
-				float intensity = Dot(normal, lightDirection);
-
-				v0 = projectionMatrix * viewMatrix * v0;
-				v1 = projectionMatrix * viewMatrix * v1;
-				v2 = projectionMatrix * viewMatrix * v2;
-
-				v0.x = v0.x / v0.w;
-				v0.y = v0.y / v0.w;
-				v0.z = v0.z / v0.w;
-				
-				v1.x = v1.x / v1.w;
-				v1.y = v1.y / v1.w;
-				v1.z = v1.z / v1.w;
-				
-				v2.x = v2.x / v2.w;
-				v2.y = v2.y / v2.w;
-				v2.z = v2.z / v2.w;
-
-				v0.x = (int)((v0.x + 1) * (bufferWidth / 2));
-				v0.y = (int)((v0.y + 1) * (bufferHeight / 2));
-				triangle[0] = Vec2i(v0.x, v0.y);
-
-				v1.x = (int)((v1.x + 1) * (bufferWidth / 2));
-				v1.y = (int)((v1.y + 1) * (bufferHeight / 2));
-				triangle[1] = Vec2i(v1.x, v1.y);
-
-				v2.x = (int)((v2.x + 1) * (bufferWidth / 2));
-				v2.y = (int)((v2.y + 1) * (bufferHeight / 2));
-				triangle[2] = Vec2i(v2.x, v2.y);
-
-				uint32_t red = ((color >> 16) & 0xFF) * intensity;
-				uint32_t green = ((color >> 8) & 0xFF) * intensity;
-				uint32_t blue = (color & 0xFF) * intensity;
-
-				uint32_t col = (red << 16) + (green << 8) + blue;
-
-				DrawTriangle(triangle, col, buffer);
+				tailX[j] = x[i + j];
+				tailY[j] = y[i + j];
+				tailZ[j] = z[i + j];
 			}
+			_mm_store_ps(tail, ShadeFaces4(_mm_load_ps(tailX), _mm_load_ps(tailY), _mm_load_ps(tailZ), matrix, light));
+			for (size_t j = 0; i + j < count; j++)
+				intensities[i + j] = tail[j];
+		}
+	}
+
+	Vec2i Model::TransformVertex(const Vec3f& position, Mat4& modelViewProjection, int bufferWidth, int bufferHeight)
+	{
+		Vec4f v = Vec4f(position.x, position.y, position.z, 1.0f);
+
+		return ProjectVertex(modelViewProjection * v, bufferWidth, bufferHeight);
+	}
+
+	/// @brief Writes the screen positions of the vertices at indices to screenVertices 4 at a time, fetching each one with position(index).
+	/// Returns how many were written, the rest of the count being less than 4.
+	template <class PositionFetch>
+	static inline uint32_t TransformVertices4(PositionFetch position, const uint32_t* indices, uint32_t count, const Mat4Columns& modelViewProjection,
+											  int bufferWidth, int bufferHeight, Vec2i* screenVertices)
+	{
+		const __m128 halfWidth = _mm_set1_ps((float)(bufferWidth / 2));
+		const __m128 halfHeight = _mm_set1_ps((float)(bufferHeight / 2));
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			Vec3fx4 points(position(indices[i]), position(indices[i + 1]), position(indices[i + 2]), position(indices[i + 3]));
+			__m128 clip[4];
+			modelViewProjection.TransformPoints(points, clip);
+
+			// Same operations as Model::ProjectVertex, truncating towards zero like its cast.
+			__m128i x = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_div_ps(clip[0], clip[3]), one), halfWidth));
+			__m128i y = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_div_ps(clip[1], clip[3]), one), halfHeight));
+			_mm_storeu_si128((__m128i*)(screenVertices + i), _mm_unpacklo_epi32(x, y));
+			_mm_storeu_si128((__m128i*)(screenVertices + i + 2), _mm_unpackhi_epi32(x, y));
 		}
+		return i;
 	}
 
-	void Model::LoadMesh(const std::string path)
+	void Model::TransformVertices(const Mesh& mesh, const uint32_t* indices, uint32_t count, const Mat4Columns& modelViewProjection,
+								  int bufferWidth, int bufferHeight, Vec2i* screenVertices)
+	{
+		uint32_t i;
+		if (mesh.IsCompressed())
+		{
+			// Only the vertices fetched are decoded, straight into the packets.
+			const QuantizedPosition* quantized = mesh.quantizedVertices.data();
+			const Vec3f offset = mesh.quantizationOffset, scale = mesh.quantizationScale;
+			i = TransformVertices4([=](uint32_t vertex) { return DecodePosition(quantized[vertex], offset, scale); },
+								   indices, count, modelViewProjection, bufferWidth, bufferHeight, screenVertices);
+		}
+		else
+		{
+			const Vec3f* positions = mesh.vertices.data();
+			i = TransformVertices4([=](uint32_t vertex) { return positions[vertex]; },
+								   indices, count, modelViewProjection, bufferWidth, bufferHeight, screenVertices);
+		}
+
+		for (; i < count; i++)
+		{
+			Vec3f position = mesh.GetVertex(indices[i]);
+			screenVertices[i] = ProjectVertex(modelViewProjection.Transform(Vec4f(position.x, position.y, position.z, 1.0f)), bufferWidth, bufferHeight);
+		}
+	}
+
+	Vec2i Model::ProjectVertex(const Vec4f& clipPosition, int bufferWidth, int bufferHeight)
+	{
+		Vec2f point = ProjectPoint(clipPosition, bufferWidth, bufferHeight);
+
+		return Vec2i((int)point.x, (int)point.y);
+	}
+
+	Vec2f Model::ProjectPoint(const Vec4f& clipPosition, int bufferWidth, int bufferHeight)
+	{
+		float x = clipPosition.x / clipPosition.w;
+		float y = clipPosition.y / clipPosition.w;
+
+		return Vec2f((x + 1) * (bufferWidth / 2), (y + 1) * (bufferHeight / 2));
+	}
+
+	void Model::LoadMesh(const std::string path, bool compressVertices)
 	{
 		// Get the model file type.
 		size_t dot = path.find_last_of('.');
@@ -158,75 +467,35 @@ namespace MiniRenderer
 
 		if (Iequals(modelType, "obj"))
 		{
-			// Load Wavefront Model File.
-			std::ifstream file;
-			file.open(path, std::ifstream::in);
-			if (file.fail()) throw std::runtime_error("Failed to open model file.\n");
-			std::string line;
-
-			// The number of meshes in this obj file.
-			int meshCount = 0;
-			int prevMeshCount = -1;
-			while (!(file >> std::ws).eof())
+			// Load Wavefront Model File, parsing it only if its mesh cache is missing or out of date.
+			if (!LoadMeshCache(path, compressVertices, meshes))
 			{
-				std::getline(file, line);
-				if (file.fail()) throw std::runtime_error("Failed read from model file.\n");
-				std::istringstream iss(line.c_str());
-				char trash;
-				if (!line.compare(0, 2, "v "))
+				size_t firstMesh = meshes.size();
+				LoadObj(path, meshes);
+				JobSystem::GetInstance()->ParallelFor(meshes.size() - firstMesh, [&](size_t i)
 				{
-					iss >> trash;
-					if (meshCount != prevMeshCount)
-					{
-						// Add the Mesh and increase the mesh count.
-						meshes.push_back(Mesh());
-						meshCount++;
-						prevMeshCount = meshCount;	// Store the last mesh count.
-					}
-
-					// Now put in the vertices value.
-					meshes[meshCount - 1].nVertices++;
-					Vec3f v;
-					iss >> v.x;
-					iss >> v.y;
-					iss >> v.z;
-					meshes[meshCount - 1].vertices.push_back(v);
-				}
-				else if (!line.compare(0, 2, "f "))
-				{
-					iss >> trash;
-					int f, t, n;
-
-					// We further increase the meshCount so if we go back to any v statement, we are writing to a new mesh and not the old one.
-					if(prevMeshCount == meshCount)	// So we only increment it once.
-						meshCount++;
-
-					iss >> f;
-					iss >> trash;
-					if (trash != '/')
-					{
-						// This means this mesh does not contain any data for tangents and normals.
-						// So we push all these 3 values as mesh faces.
-						meshes[prevMeshCount - 1].nFaces += 3;
-						meshes[prevMeshCount - 1].faces.push_back(f);
-						meshes[prevMeshCount - 1].faces.push_back(int(trash - '0'));	// Trash value is the second face index.
-						iss >> f;	// Third face index.
-						meshes[prevMeshCount - 1].faces.push_back(f);
-					}
-					else
-					{
-						// f faces/tangent/normal
-						iss >> t >> trash >> n;
-						// For now we only care about the faces so just store that value.
-						meshes[prevMeshCount - 1].nFaces++;
-						meshes[prevMeshCount - 1].faces.push_back(f);
-					}
-				}
+					OptimizeMesh(meshes[firstMesh + i]);
+					GenerateLods(meshes[firstMesh + i]);
+					ComputeNormals(meshes[firstMesh + i]);
+					if (compressVertices) CompressMesh(meshes[firstMesh + i]);
+					ComputeBounds(meshes[firstMesh + i]);
+				});
+				SaveMeshCache(path, compressVertices, meshes, firstMesh);
 			}
 		}
-		else if (Iequals(modelType, "gltf"))
+		else if (Iequals(modelType, "gltf") || Iequals(modelType, "glb"))
 		{
-			// Load GLTF Model File.
+			// Load GLTF Model File. Its buffers are already binary so it isn't cached, & its index buffers may be used in place
+			// unless levels of detail are added to them.
+			size_t firstMesh = meshes.size();
+			LoadGltf(path, meshes);
+			JobSystem::GetInstance()->ParallelFor(meshes.size() - firstMesh, [&](size_t i)
+			{
+				GenerateLods(meshes[firstMesh + i]);
+				ComputeNormals(meshes[firstMesh + i]);
+				if (compressVertices) CompressMesh(meshes[firstMesh + i]);
+				ComputeBounds(meshes[firstMesh + i]);
+			});
 		}
 
 	}
@@ -1,42 +1,149 @@
 #pragma once
 
 #include "Maths/Maths.h"
+#include "Maths/VertexFormats.h"
+#include "Maths/Bounds.h"
 #include "Framebuffer.h"
 #include "Camera.h"
+#include "MeshBuffer.h"
 #include <vector>
 #include <string>
 
 namespace MiniRenderer
 {
+	class OcclusionBuffer;
+
+	/// @brief Run of consecutive triangles of a Mesh(a meshlet) that is culled & transformed as a whole.
+	struct MeshCluster
+	{
+		BoundingBox box;
+		BoundingSphere sphere;
+		Vec3f coneAxis;		// Average direction of the face normals
+		float coneCutoff;	// Sine of the largest angle between coneAxis & a face normal, 1 if the normals are too spread out to cull by
+		uint32_t firstTriangle;
+		uint32_t triangleCount;
+		uint32_t firstVertex;	// Vertices of the cluster, in Mesh::clusterVertices
+		uint32_t vertexCount;
+	};
+
+	/// @brief Level of detail of a Mesh: a simplified copy of its faces, drawn in place of them when it is small on screen.
+	struct MeshLod
+	{
+		uint32_t firstTriangle;	// Triangles of the level, in Mesh::faces
+		uint32_t triangleCount;
+		uint32_t firstCluster;	// Clusters covering the triangles of the level, in Mesh::clusters
+		uint32_t clusterCount;
+		float error;	// How far the simplified surface may be from the full detail one, in model space
+	};
+
 	/// @brief Has all the vertex data from the model file.
 	struct Mesh
 	{
-		std::vector<Vec3f> vertices;	// Vertices
+		MeshBuffer<Vec3f> vertices;	// Vertices
+		MeshBuffer<Vec2f> texcoords;	// Texture Coordinates, one per Vertex or none
+		MeshBuffer<Vec3f> normals;	// Normals, one per Vertex or none
 		uint32_t nVertices;	// Number of Vertices
-		std::vector<unsigned int> faces;	// Faces
-		uint32_t nFaces;	// Number of Faces
+		MeshBuffer<unsigned int> faces;	// Faces, 3 zero based Vertex indices per Triangle
+		MeshBuffer<float> faceNormalsX, faceNormalsY, faceNormalsZ;	// Face Normals, one per Triangle, split by component so they are transformed 4 at a time
+		uint32_t nFaces;	// Number of Faces of the full detail mesh, the levels of detail follow them in faces
+		bool counterClockwise = false;	// If the front of the Faces is wound counter clockwise(glTF) instead of clockwise(OBJ)
+
+		// Compressed vertex data, used instead of vertices, normals & texcoords once the Mesh is compressed(see CompressMesh).
+		MeshBuffer<QuantizedPosition> quantizedVertices;	// Vertices, quantized inside the bounds of the Mesh
+		MeshBuffer<OctNormal> octNormals;	// Normals, octahedral encoded, only stored as nothing is shaded from vertex normals yet
+		MeshBuffer<HalfTexcoord> halfTexcoords;	// Texture Coordinates, half precision, only stored as nothing is textured yet
+		Vec3f quantizationOffset, quantizationScale;	// Vertex = quantizationOffset + quantizedVertex * quantizationScale
+
+		// Bounds in model space, used to cull the Mesh & its clusters(see ComputeBounds).
+		BoundingBox box;
+		BoundingSphere sphere;
+		MeshBuffer<MeshCluster> clusters;	// Clusters covering all Faces in order
+		MeshBuffer<unsigned int> clusterVertices;	// Vertex indices used by every cluster
+		MeshBuffer<uint8_t> clusterIndices;	// Faces, 3 indices per Triangle into the vertices of its cluster
+
+		MeshBuffer<MeshLod> lods;	// Levels of detail from the full detail mesh on, coarser & coarser(see GenerateLods), or none
+
+		MeshBuffer<uint32_t> edges;	// Unique edges of the full detail Faces, 2 Vertex indices per edge, computed when first drawn as a wireframe(see ComputeEdges)
 
 		Mesh() : vertices(), nVertices(0), faces(), nFaces(0) {}
-		Mesh(std::vector<Vec3f> verts, uint32_t nVerts, std::vector<unsigned int> f, uint32_t nF) : vertices(verts), nVertices(nVerts), faces(f), nFaces(nF) {}
+		Mesh(std::vector<Vec3f> verts, uint32_t nVerts, std::vector<unsigned int> f, uint32_t nF) : vertices(std::move(verts)), nVertices(nVerts), faces(std::move(f)), nFaces(nF) {}
+
+		/// @brief Returns if the vertex data is stored compressed.
+		bool IsCompressed() const { return !quantizedVertices.empty(); }
+
+		/// @brief Returns the position of the vertex, decoding it if the Mesh is compressed.
+		Vec3f GetVertex(uint32_t vertex) const
+		{
+			return IsCompressed() ? DecodePosition(quantizedVertices[vertex], quantizationOffset, quantizationScale) : vertices[vertex];
+		}
 	};
 
 	/// @brief Has all Mesh, texture & material data.
 	class Model
 	{
 	public:
-		/// @brief Loads the Mesh with the values in path
-		Model(const std::string path);
+		/// @brief Loads the Mesh with the values in path, storing the vertex data compressed if compressVertices is set.
+		Model(const std::string path, bool compressVertices = false);
 		~Model() {}
 	public:
 		std::vector<Mesh> meshes;
-		/// @brief Draws the given Mesh as lines with the desired color to the given buffer.
-		void DrawWireframe(Framebuffer& buffer, uint32_t meshIndex = 0, uint32_t color = 0xFFFF00);
+		/// @brief Draws the edges of the given Mesh as lines with the desired color to the given buffer, placed by modelMatrix.
+		/// Every vertex is transformed once & every edge shared by triangles is drawn once. Edges crossing the near plane are cut at it.
+		/// If antialiased is set, the lines are anti-aliased & blended over the buffer instead, e.g. to overlay a shaded mesh.
+		void DrawWireframe(Framebuffer& buffer, Camera& camera, Mat4& modelMatrix, uint32_t meshIndex = 0, uint32_t color = 0xFFFF00, bool antialiased = false);
+
+		/// @brief Draws the given Mesh as triangles with the desired color to the given buffer, placed by modelMatrix.
+		void Draw(Framebuffer& buffer, Camera& camera, Mat4& modelMatrix, uint32_t meshIndex = 0, uint32_t color = 0xFFFF00);
 
-		/// @brief Draws the given Mesh as triangles with the desired color to the given buffer.
-		void Draw(Framebuffer& buffer, Camera& camera, uint32_t meshIndex = 0, uint32_t color = 0xFFFF00);
+		/// @brief Draws instanceCount copies of the given Mesh as triangles to the given buffer, copy i placed by modelMatrices[i] & drawn with colors[i].
+		/// The vertices are fetched & decoded once for all the copies. Copies & clusters of the Mesh outside the view, & clusters facing away from it,
+		/// are culled before their vertices are transformed, as are those hidden in occlusion if given. The clusters of large meshes are transformed in parallel.
+		/// Every copy is drawn with the coarsest level of detail that stays within LOD_PIXEL_ERROR on screen. If given, lodLevels holds the level
+		/// each copy was drawn with last time & is updated, so that copies near the switching distance don't flicker between levels.
+		/// If given, only the instanceCount copies listed in instances are drawn(e.g. those found visible by a Bvh), in that order.
+		void DrawInstances(Framebuffer& buffer, Camera& camera, Mat4* modelMatrices, const uint32_t* colors, size_t instanceCount, uint32_t meshIndex = 0,
+						   const OcclusionBuffer* occlusion = nullptr, uint8_t* lodLevels = nullptr, const uint32_t* instances = nullptr);
+
+		/// @brief Returns if the ray origin + t * direction in model space hits a full detail triangle of any Mesh with 0 <= t <= distance,
+		/// lowering distance to the nearest hit. Only the clusters whose box the ray hits are tested.
+		bool Intersect(const Vec3f& origin, const Vec3f& direction, float& distance) const;
 	private:
 		/// @brief Loads the Mesh with the values in path
-		void LoadMesh(const std::string path);
+		void LoadMesh(const std::string path, bool compressVertices);
+
+		/// @brief Returns the screen position of position, transformed by modelViewProjection.
+		static Vec2i TransformVertex(const Vec3f& position, Mat4& modelViewProjection, int bufferWidth, int bufferHeight);
+
+		/// @brief Writes the screen positions of the count vertices of mesh at indices, transformed by the columns of the modelViewProjection matrix, to screenVertices.
+		/// Transforms & projects 4 vertices at a time, giving the same result as TransformVertex. Compressed positions are decoded as they are fetched.
+		static void TransformVertices(const Mesh& mesh, const uint32_t* indices, uint32_t count, const Mat4Columns& modelViewProjection,
+									  int bufferWidth, int bufferHeight, Vec2i* screenVertices);
+
+		/// @brief Returns the screen position of the clip space position, which has to be in front of the camera.
+		static Vec2i ProjectVertex(const Vec4f& clipPosition, int bufferWidth, int bufferHeight);
+
+		/// @brief Returns the screen position of the clip space position with its fraction of a pixel, for anti-aliased drawing.
+		static Vec2f ProjectPoint(const Vec4f& clipPosition, int bufferWidth, int bufferHeight);
+
+		/// @brief Writes the lighting of the triangleCount faces of mesh from firstTriangle on to intensities, from their normals transformed by normalMatrix.
+		static void ShadeFaces(const Mesh& mesh, uint32_t firstTriangle, uint32_t triangleCount, const Vec3f normalMatrix[3], const Vec3f& lightDirection, float* intensities);
+	private:
+		/// @brief Vertices of the clusters of the mesh being drawn in screen space, in the order of Mesh::clusterVertices.
+		std::vector<Vec2i> m_ScreenVertices;
+
+		/// @brief Clusters of the mesh being drawn that are visible.
+		std::vector<uint32_t> m_VisibleClusters;
+
+		/// @brief Lighting of every face of the mesh being drawn.
+		std::vector<float> m_FaceIntensities;
+
+		/// @brief Vertices of the mesh drawn as a wireframe in clip space & in screen space, whole or with fractions of pixels if anti-aliased.
+		AlignedVector<Vec4f> m_ClipVertices;
+		std::vector<Vec2i> m_LineVertices;
+		std::vector<Vec2f> m_LinePoints;
+
+		/// @brief Edges of the mesh drawn as a wireframe that lie in front of the near plane, 2 indices into m_LineVertices per edge.
+		std::vector<uint32_t> m_LineEdges;
 	};
 
 	/// @brief Returns if the two strings are equal(case insensitive)
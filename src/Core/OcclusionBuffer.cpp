@@ -0,0 +1,171 @@
+#include "OcclusionBuffer.h"
+#include <cfloat>
+#include <cmath>
+
+namespace MiniRenderer
+{
+	/// @brief Geometry nearer than this view depth can't be projected safely, so it is neither an occluder nor tested.
+	static const float MIN_OCCLUSION_DEPTH = 1e-3f;
+
+	/// @brief Returns the columns of matrix, so that matrix * (x, y, z, 1) = columns[0] * x + columns[1] * y + columns[2] * z + columns[3].
+	static inline void LoadColumns(const Mat4& matrix, __m128 columns[4])
+	{
+		for (int i = 0; i < 4; i++)
+			columns[i] = _mm_setr_ps(matrix(0, i), matrix(1, i), matrix(2, i), matrix(3, i));
+	}
+
+	/// @brief Returns the clip space position of the point.
+	static inline __m128 TransformPoint(const __m128 columns[4], float x, float y, float z)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0], _mm_set1_ps(x)), _mm_mul_ps(columns[1], _mm_set1_ps(y))),
+						  _mm_add_ps(_mm_mul_ps(columns[2], _mm_set1_ps(z)), columns[3]));
+	}
+
+	/// @brief Returns the clip space position as (x, y) in buffer coordinates & w.
+	static inline Vec4f ToBuffer(__m128 clip)
+	{
+		alignas(16) float v[4];
+		_mm_store_ps(v, clip);
+		float inverseW = 1.0f / v[3];
+		return Vec4f((v[0] * inverseW + 1.0f) * (OcclusionBuffer::WIDTH * 0.5f), (v[1] * inverseW + 1.0f) * (OcclusionBuffer::HEIGHT * 0.5f), 0.0f, v[3]);
+	}
+
+	OcclusionBuffer::OcclusionBuffer() : m_Depth(WIDTH * HEIGHT, FLT_MAX)
+	{
+	}
+
+	void OcclusionBuffer::Clear()
+	{
+		if (m_Empty) return;
+		std::fill(m_Depth.begin(), m_Depth.end(), FLT_MAX);
+		m_Empty = true;
+	}
+
+	void OcclusionBuffer::RenderOccluder(const Mesh& mesh, const Mat4& modelViewProjection)
+	{
+		__m128 columns[4];
+		LoadColumns(modelViewProjection, columns);
+
+		// Always the full detail faces, a coarser level of detail may reach past the surface & hide what is in front of it.
+		const size_t triangleCount = mesh.nFaces / 3;
+		for (size_t i = 0; i < triangleCount; i++)
+		{
+			__m128 clip[3];
+			bool inFront = true;
+			for (int k = 0; k < 3; k++)
+			{
+				Vec3f p = mesh.GetVertex(mesh.faces[i * 3 + k]);
+				clip[k] = TransformPoint(columns, p.x, p.y, p.z);
+				inFront = inFront && _mm_cvtss_f32(_mm_shuffle_ps(clip[k], clip[k], _MM_SHUFFLE(3, 3, 3, 3))) > MIN_OCCLUSION_DEPTH;
+			}
+
+			// Triangles crossing the camera plane are left out, which is conservative.
+			if (inFront)
+				RasterizeTriangle(ToBuffer(clip[0]), ToBuffer(clip[1]), ToBuffer(clip[2]));
+		}
+	}
+
+	void OcclusionBuffer::RasterizeTriangle(const Vec4f& v0, const Vec4f& v1, const Vec4f& v2)
+	{
+		// Edge functions E(x, y) = a * x + b * y + c, positive inside whatever the winding.
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (!(std::fabs(area) > 0.0f)) return;
+		const float sign = area > 0.0f ? 1.0f : -1.0f;
+
+		const Vec4f* vertices[3] = { &v0, &v1, &v2 };
+		float a[3], b[3], c[3];
+		for (int e = 0; e < 3; e++)
+		{
+			const Vec4f& p = *vertices[e];
+			const Vec4f& q = *vertices[(e + 1) % 3];
+			a[e] = (p.y - q.y) * sign;
+			b[e] = (q.x - p.x) * sign;
+			c[e] = (p.x * q.y - p.y * q.x) * sign;
+
+			// Evaluating at pixel centers, a pixel is entirely inside an edge if its center is at least half its extent inside.
+			c[e] -= 0.5f * (std::fabs(a[e]) + std::fabs(b[e]));
+		}
+
+		int minX = (int)std::floor(std::fmin(v0.x, std::fmin(v1.x, v2.x)));
+		int maxX = (int)std::ceil(std::fmax(v0.x, std::fmax(v1.x, v2.x)));
+		int minY = (int)std::floor(std::fmin(v0.y, std::fmin(v1.y, v2.y)));
+		int maxY = (int)std::ceil(std::fmax(v0.y, std::fmax(v1.y, v2.y)));
+		minX = Max(minX, 0); maxX = Min(maxX, WIDTH - 1);
+		minY = Max(minY, 0); maxY = Min(maxY, HEIGHT - 1);
+		if (minX > maxX || minY > maxY) return;
+
+		// 4 pixels at a time, starting at a multiple of 4 so the rows are loaded aligned to their start.
+		minX &= ~3;
+		const __m128 depth = _mm_set1_ps(std::fmax(v0.w, std::fmax(v1.w, v2.w)));
+		const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		__m128 edgeA[3], edgeB[3], edgeC[3];
+		for (int e = 0; e < 3; e++)
+		{
+			edgeA[e] = _mm_set1_ps(a[e]);
+			edgeB[e] = _mm_set1_ps(b[e]);
+			edgeC[e] = _mm_set1_ps(c[e]);
+		}
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			const __m128 centerY = _mm_set1_ps(y + 0.5f);
+			float* row = m_Depth.data() + y * WIDTH;
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				const __m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+				__m128 inside = _mm_set1_ps(-1.0f);
+				for (int e = 0; e < 3; e++)
+				{
+					__m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[e], centerX), _mm_mul_ps(edgeB[e], centerY)), edgeC[e]);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(value, _mm_setzero_ps()));
+				}
+				if (_mm_movemask_ps(inside) == 0) continue;
+
+				__m128 current = _mm_load_ps(row + x);
+				_mm_store_ps(row + x, _mm_blendv_ps(current, _mm_min_ps(current, depth), inside));
+				m_Empty = false;
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible(const BoundingBox& box, const Mat4& modelViewProjection) const
+	{
+		if (m_Empty) return true;
+
+		__m128 columns[4];
+		LoadColumns(modelViewProjection, columns);
+
+		// Screen rectangle & nearest depth of the 8 corners.
+		float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			__m128 clip = TransformPoint(columns, corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y, corner & 4 ? box.max.z : box.min.z);
+			if (_mm_cvtss_f32(_mm_shuffle_ps(clip, clip, _MM_SHUFFLE(3, 3, 3, 3))) <= MIN_OCCLUSION_DEPTH)
+				return true;
+
+			Vec4f p = ToBuffer(clip);
+			minX = std::fmin(minX, p.x); maxX = std::fmax(maxX, p.x);
+			minY = std::fmin(minY, p.y); maxY = std::fmax(maxY, p.y);
+			nearest = std::fmin(nearest, p.w);
+		}
+
+		// Every pixel the rectangle touches.
+		int x0 = Max((int)std::floor(minX), 0), x1 = Min((int)std::floor(maxX), WIDTH - 1);
+		int y0 = Max((int)std::floor(minY), 0), y1 = Min((int)std::floor(maxY), HEIGHT - 1);
+		if (x0 > x1 || y0 > y1) return false;
+
+		const __m128 depth = _mm_set1_ps(nearest);
+		for (int y = y0; y <= y1; y++)
+		{
+			const float* row = m_Depth.data() + y * WIDTH;
+			int x = x0;
+			for (; x + 4 <= x1 + 1; x += 4)
+				if (_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(row + x), depth)) != 0)
+					return true;
+			for (; x <= x1; x++)
+				if (row[x] > nearest)
+					return true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,37 @@
+// Low resolution depth buffer of the large occluders in view, used to skip geometry hidden behind them.
+#pragma once
+
+#include "Model.h"
+#include <vector>
+
+namespace MiniRenderer
+{
+	class OcclusionBuffer
+	{
+	public:
+		static const int WIDTH = 256;
+		static const int HEIGHT = 128;
+
+		OcclusionBuffer();
+
+		/// @brief Resets every pixel to infinitely far.
+		void Clear();
+
+		/// @brief Rasterizes the triangles of mesh, placed by modelViewProjection, into the buffer.
+		/// Depth is stored conservatively: a pixel is only written if a triangle covers it entirely, with the farthest depth of that triangle.
+		void RenderOccluder(const Mesh& mesh, const Mat4& modelViewProjection);
+
+		/// @brief Returns if any part of box, placed by modelViewProjection, may be in front of the occluders, i.e. false only if it is surely hidden.
+		bool IsVisible(const BoundingBox& box, const Mat4& modelViewProjection) const;
+
+		/// @brief Returns if the buffer has no occluders in it.
+		bool IsEmpty() const { return m_Empty; }
+	private:
+		/// @brief Rasterizes one triangle given in buffer coordinates(x, y) with view depth w.
+		void RasterizeTriangle(const Vec4f& v0, const Vec4f& v1, const Vec4f& v2);
+	private:
+		/// @brief View depth(clip space w) of the nearest occluder at every pixel, row by row.
+		AlignedVector<float> m_Depth;
+		bool m_Empty = true;
+	};
+}
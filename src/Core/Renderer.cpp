@@ -9,12 +9,28 @@
 
 namespace MiniRenderer
 {
+	/// @brief Color of the picked instance.
+	static const uint32_t PICKED_COLOR = 0xFF4000;
+
+	static const size_t NO_INSTANCE = (size_t)-1;
+
 	Renderer::Renderer(const WindowProperties& props, short unsigned int targetFPS, bool doubleBuffer)
 		: m_Swapchain(props.Width, props.Height), m_TargetFPS(targetFPS), m_DoubleBuffer(doubleBuffer), 
-		  m_TestModel(PROJECT_DIR"/src/Assets/pyramid.obj"), m_Camera(Vec3f(0.0f, 0.0f, 5.0f)), 
-		  m_LastX(props.Width * 0.5f), m_LastY(props.Height * 0.5f), m_FirstMouse(true), m_RightClickHeld(false)
+		  m_Camera(Vec3f(0.0f, 0.0f, 5.0f)), 
+		  m_LastX(props.Width * 0.5f), m_LastY(props.Height * 0.5f), m_FirstMouse(true), m_RightClickHeld(false),
+		  m_PickedInstance(NO_INSTANCE), m_PickedInstanceColor(0)
 	{
 		m_Window = MiniWindow::Create(props);
+
+		// Test Model, loaded in the background.
+		Mat4 modelMatrix;
+		modelMatrix.Identity();
+		Scale(modelMatrix, Vec3f(1.5f, 2.5f, 1.5f));
+		Rotate(modelMatrix, ToRadians(-10.0f), Vec3f(0.0f, 0.0f, 1.0f));
+		Rotate(modelMatrix, ToRadians(20.0f), Vec3f(1.0f, 0.0f, 0.0f));
+		Rotate(modelMatrix, ToRadians(45.0f), Vec3f(0.0f, 1.0f, 0.0f));
+		Translate(modelMatrix, Vec3f(0.0f, 1.0f, -4.0f));
+		m_Scene.AddInstance(AssetLoader::GetInstance()->LoadModel(PROJECT_DIR"/src/Assets/pyramid.obj"), modelMatrix);
 	}
 
 	Renderer::~Renderer()
@@ -31,6 +47,18 @@ namespace MiniRenderer
 
 	void Renderer::Init()
 	{
+		// Backbuffer is cleared every frame, so only fill the tiles we don't draw to at present.
+		m_Swapchain.backBuffer.EnableFastClear(true);
+
+		// Store the backbuffer in micro tiles for the rasterizer, it is converted to linear when it is presented.
+		m_Swapchain.backBuffer.SetLayout(FramebufferLayout::Tiled);
+
+		// Keep alpha next to the color, so blending only has to touch one plane.
+		m_Swapchain.backBuffer.EnablePackedAlpha(true);
+
+		// Anti-alias triangle edges with 4 samples per pixel, the samples are averaged when the backbuffer is presented.
+		m_Swapchain.backBuffer.SetSampleCount(4);
+
 		// Add Listener of Events.
 		EventHandler::GetInstance()->WindowEventDispatcher.AddListener(WindowEvents::WindowResize, std::bind(&Renderer::OnWindowEvent, this, std::placeholders::_1));
 		EventHandler::GetInstance()->WindowEventDispatcher.AddListener(WindowEvents::WindowClose, std::bind(&Renderer::OnWindowEvent, this, std::placeholders::_1));
@@ -155,9 +183,8 @@ namespace MiniRenderer
 		//Vec2i points[3] = { Vec2i(40, 200), Vec2i(80, 120), Vec2i(120, 200) };
 		//DrawTriangle(points, 0x069C4F, m_Swapchain.backBuffer);
 
-		// Render model.
-		m_TestModel.Draw(m_Swapchain.backBuffer, m_Camera);
-		//m_TestModel.DrawWireframe(m_Swapchain.backBuffer);
+		// Render the models that have been loaded.
+		m_Scene.Draw(m_Swapchain.backBuffer, m_Camera);
 
 		// The Swapchain swaps the buffer if only our backbuffer is completed which we set manually.
 		m_Swapchain.SetBackbufferState(true);
@@ -221,7 +248,11 @@ namespace MiniRenderer
 		{
 			// Mouse Button Down Event.
 			const MouseButtonDownEvent& mm = static_cast<const MouseButtonDownEvent&>(e);
-			if (mm.button == 3)
+			if (mm.button == 1)
+			{
+				PickInstance();
+			}
+			else if (mm.button == 3)
 			{
 				m_RightClickHeld = true;
 				m_Window->RenderCursor(false);	// Hide Cursor
@@ -263,6 +294,32 @@ namespace MiniRenderer
 		}
     }
 
+	void Renderer::PickInstance()
+	{
+		// Ray through the center of the pixel under the cursor, in the same normalized device coordinates the scene is drawn with.
+		int bufferWidth = m_Swapchain.backBuffer.GetFramebufferWidth();
+		int bufferHeight = m_Swapchain.backBuffer.GetFramebufferHeight();
+		float x = (m_LastX + 0.5f) / bufferWidth * 2.0f - 1.0f;
+		float y = (m_LastY + 0.5f) / bufferHeight * 2.0f - 1.0f;
+		Vec3f direction = m_Camera.GetRayDirection(x, y, (float)bufferWidth / (float)bufferHeight);
+
+		if (m_PickedInstance != NO_INSTANCE)
+			m_Scene.SetColor(m_PickedInstance, m_PickedInstanceColor);
+
+		size_t instance;
+		float distance;
+		if (m_Scene.Pick(m_Camera.Position, direction, instance, distance))
+		{
+			m_PickedInstance = instance;
+			m_PickedInstanceColor = m_Scene.GetColor(instance);
+			m_Scene.SetColor(instance, PICKED_COLOR);
+		}
+		else
+		{
+			m_PickedInstance = NO_INSTANCE;
+		}
+	}
+
 	void Renderer::SendWSADInput()
 	{
 		if (m_WSADheld.w == 1)
@@ -288,10 +345,14 @@ namespace MiniRenderer
 		int startingPixelX = midX - sizeX / 2;
 		int startingPixelY = midY - sizeY / 2;
 
+		// Clip the rectangle against the backbuffer once, so the pixels can be written unchecked.
+		int minX = Max(startingPixelX, 0), maxX = Min(startingPixelX + sizeX, framebufferWidth - 1);
+		int minY = Max(startingPixelY, 0), maxY = Min(startingPixelY + sizeY, framebufferHeight - 1);
+
 		// Send draw command for every pixel.
-		for (int x = startingPixelX; x <= startingPixelX + sizeX; x++)
-			for (int y = startingPixelY; y <= startingPixelY + sizeY; y++)
-				m_Swapchain.backBuffer.SetPixelColor(x, y, (y - x) * 0x00FFFF);
+		for (int y = minY; y <= maxY; y++)
+			for (int x = minX; x <= maxX; x++)
+				m_Swapchain.backBuffer.SetPixelColorUnchecked(x, y, (y - x) * 0x00FFFF);
 	}
 
 	void Renderer::DrawLines()
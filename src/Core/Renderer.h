@@ -7,6 +7,7 @@
 #include "Events/EventHandler.h"
 #include "Swapchain.h"
 #include "Model.h"
+#include "Scene.h"
 #include "Camera.h"
 
 namespace MiniRenderer
@@ -49,6 +50,9 @@ namespace MiniRenderer
 		/// @brief Called when keyboard events(key down or key up) happen.
 		void OnKeyEvent(const Event<KeyEvents>& e);
 
+		/// @brief Picks the instance under the mouse cursor & highlights it.
+		void PickInstance();
+
 		/// @brief Sends the WSAD input to the camera.
 		void SendWSADInput();
 
@@ -82,8 +86,8 @@ namespace MiniRenderer
 		/// @brief The Time at which we started waiting.
 		long long m_TimeWhenWeStartedWaiting = 0;
 
-		/// @brief Test Model.
-		Model m_TestModel;
+		/// @brief Instances of the models being rendered, each drawn once its model is loaded.
+		Scene m_Scene;
 
 		/// Scene Fly Cam.
 		Camera m_Camera;
@@ -96,6 +100,10 @@ namespace MiniRenderer
 		// We only want to rotate the camera if the right click is held down.
 		bool m_RightClickHeld;
 
+		// Instance picked with the left click, drawn in PICKED_COLOR till another one is picked.
+		size_t m_PickedInstance;
+		uint32_t m_PickedInstanceColor;
+
 		struct WSADheld
 		{
 			unsigned char w : 1;
@@ -0,0 +1,250 @@
+#include "Scene.h"
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+#include <stdexcept>
+
+namespace MiniRenderer
+{
+	size_t Scene::AddInstance(const ModelHandle& model, const Mat4& transform, uint32_t color, bool occluder)
+	{
+		size_t batch = 0;
+		while (batch < m_Batches.size() && !(m_Batches[batch].model == model && m_Batches[batch].occluder == occluder))
+			batch++;
+		if (batch == m_Batches.size())
+		{
+			m_Batches.emplace_back();
+			m_Batches.back().model = model;
+			m_Batches.back().occluder = occluder;
+		}
+
+		m_Batches[batch].transforms.push_back(transform);
+		m_Batches[batch].colors.push_back(color);
+		m_Instances.push_back({ batch, m_Batches[batch].transforms.size() - 1 });
+		m_Bounds.emplace_back();
+		if (occluder)
+			m_Occluders.push_back((uint32_t)(m_Instances.size() - 1));
+
+		// The box of the new instance is computed & added to the Bvh before the next Draw.
+		m_Batches[batch].bounded = false;
+		return m_Instances.size() - 1;
+	}
+
+	void Scene::SetTransform(size_t instance, const Mat4& transform)
+	{
+		if (instance >= m_Instances.size())
+			throw std::runtime_error("Scene instance doesn't exist!\n");
+
+		const InstanceSlot& slot = m_Instances[instance];
+		Batch& batch = m_Batches[slot.batch];
+		batch.transforms[slot.index] = transform;
+
+		// Moving instances only refit the Bvh, which is cheaper than rebuilding it.
+		if (batch.bounded)
+		{
+			m_Bounds[instance] = TransformBox(batch.bounds, transform);
+			if (!batch.occluder && !m_BvhDirty)
+				m_Bvh.Refit((uint32_t)instance, m_Bounds[instance]);
+		}
+	}
+
+	const Mat4& Scene::GetTransform(size_t instance) const
+	{
+		if (instance >= m_Instances.size())
+			throw std::runtime_error("Scene instance doesn't exist!\n");
+
+		const InstanceSlot& slot = m_Instances[instance];
+		return m_Batches[slot.batch].transforms[slot.index];
+	}
+
+	void Scene::SetColor(size_t instance, uint32_t color)
+	{
+		if (instance >= m_Instances.size())
+			throw std::runtime_error("Scene instance doesn't exist!\n");
+
+		const InstanceSlot& slot = m_Instances[instance];
+		m_Batches[slot.batch].colors[slot.index] = color;
+	}
+
+	uint32_t Scene::GetColor(size_t instance) const
+	{
+		if (instance >= m_Instances.size())
+			throw std::runtime_error("Scene instance doesn't exist!\n");
+
+		const InstanceSlot& slot = m_Instances[instance];
+		return m_Batches[slot.batch].colors[slot.index];
+	}
+
+	Model* Scene::GetModel(size_t batch)
+	{
+		Batch& b = m_Batches[batch];
+		if (!b.failed && b.model.GetState() == AssetState::Failed)
+		{
+			// One broken asset shouldn't stop the render loop, its instances are left out.
+			std::cerr << "Failed to load a Scene model, its instances are skipped: " << b.model.GetError() << std::endl;
+			b.failed = true;
+		}
+		return b.model.Get();
+	}
+
+	void Scene::UpdateBvh()
+	{
+		std::vector<bool> bounded(m_Batches.size(), false);
+		bool anyBounded = false;
+		for (size_t b = 0; b < m_Batches.size(); b++)
+		{
+			Batch& batch = m_Batches[b];
+			Model* model = batch.bounded ? nullptr : GetModel(b);
+			if (model == nullptr) continue;
+
+			batch.bounds = { Vec3f(FLT_MAX, FLT_MAX, FLT_MAX), Vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+			for (const Mesh& mesh : model->meshes)
+				batch.bounds = MergeBoxes(batch.bounds, mesh.box);
+			batch.bounded = true;
+			bounded[b] = anyBounded = true;
+			m_BvhDirty = m_BvhDirty || !batch.occluder;
+		}
+
+		// Boxes of the instances of just loaded models, occluders included since Pick() tests them too.
+		// Instances of batches bounded earlier are kept up to date by SetTransform().
+		if (anyBounded)
+		{
+			for (size_t instance = 0; instance < m_Instances.size(); instance++)
+			{
+				const InstanceSlot& slot = m_Instances[instance];
+				if (bounded[slot.batch])
+					m_Bounds[instance] = TransformBox(m_Batches[slot.batch].bounds, m_Batches[slot.batch].transforms[slot.index]);
+			}
+		}
+		if (!m_BvhDirty) return;
+
+		// Occluders are few & drawn before the others so they are kept out of the Bvh.
+		std::vector<uint32_t> ids;
+		std::vector<BoundingBox> boxes;
+		for (size_t instance = 0; instance < m_Instances.size(); instance++)
+		{
+			const Batch& batch = m_Batches[m_Instances[instance].batch];
+			if (!batch.bounded || batch.occluder) continue;
+			ids.push_back((uint32_t)instance);
+			boxes.push_back(m_Bounds[instance]);
+		}
+		m_Bvh.Build(ids.data(), boxes.data(), ids.size());
+		m_BvhDirty = false;
+	}
+
+	void Scene::Draw(Framebuffer& buffer, Camera& camera)
+	{
+		UpdateBvh();
+
+		// Occlusion pre-pass: the occluders are drawn to the depth buffer first, so everything else can be tested against them.
+		m_Occlusion.Clear();
+		Mat4 projectionMatrix = camera.GetProjectionMatrix((float)buffer.GetFramebufferWidth() / (float)buffer.GetFramebufferHeight()), viewMatrix = camera.GetViewMatrix();
+		Mat4 viewProjection = projectionMatrix * viewMatrix;
+		for (size_t b = 0; b < m_Batches.size(); b++)
+		{
+			Batch& batch = m_Batches[b];
+			Model* model = batch.occluder ? GetModel(b) : nullptr;
+			if (model == nullptr) continue;
+
+			for (Mat4& transform : batch.transforms)
+			{
+				Mat4 modelViewProjection = viewProjection * transform;
+				for (const Mesh& mesh : model->meshes)
+					m_Occlusion.RenderOccluder(mesh, modelViewProjection);
+			}
+		}
+
+		// Find the visible instances through the Bvh & hand them to their batches, keeping the order they were added in.
+		const OcclusionBuffer* occlusion = m_Occlusion.IsEmpty() ? nullptr : &m_Occlusion;
+		m_Visible.clear();
+		m_Bvh.Cull(ExtractFrustum(viewProjection), occlusion, viewProjection, m_Visible);
+		std::sort(m_Visible.begin(), m_Visible.end());
+		for (Batch& batch : m_Batches)
+			batch.visible.clear();
+		for (uint32_t instance : m_Visible)
+			m_Batches[m_Instances[instance].batch].visible.push_back((uint32_t)m_Instances[instance].index);
+
+		for (size_t b = 0; b < m_Batches.size(); b++)
+		{
+			// Models that are still loading are skipped till they are ready, & those that failed for good.
+			Batch& batch = m_Batches[b];
+			Model* model = GetModel(b);
+			if (model == nullptr) continue;
+
+			// The levels are stored per mesh, so a new instance moves the levels of the later meshes along. Existing instances keep
+			// their history, otherwise they would all snap back to full detail for a frame.
+			const size_t instanceCount = batch.transforms.size();
+			const size_t meshCount = model->meshes.size();
+			if (batch.lods.size() != meshCount * instanceCount)
+			{
+				const size_t oldCount = meshCount == 0 ? 0 : batch.lods.size() / meshCount;
+				const size_t keptCount = std::min(oldCount, instanceCount);
+				std::vector<uint8_t> lods(meshCount * instanceCount, 0);
+				for (size_t mesh = 0; mesh < meshCount; mesh++)
+					std::copy(batch.lods.begin() + mesh * oldCount, batch.lods.begin() + mesh * oldCount + keptCount, lods.begin() + mesh * instanceCount);
+				batch.lods.swap(lods);
+			}
+
+			// Occluders are not tested against themselves, they would hide each other wherever they overlap.
+			for (uint32_t mesh = 0; mesh < model->meshes.size(); mesh++)
+			{
+				if (batch.occluder)
+					model->DrawInstances(buffer, camera, batch.transforms.data(), batch.colors.data(), instanceCount, mesh, nullptr, batch.lods.data() + mesh * instanceCount);
+				else if (!batch.visible.empty())
+					model->DrawInstances(buffer, camera, batch.transforms.data(), batch.colors.data(), batch.visible.size(), mesh, occlusion,
+										 batch.lods.data() + mesh * instanceCount, batch.visible.data());
+			}
+		}
+	}
+
+	bool Scene::IntersectInstance(size_t instance, const Vec3f& origin, const Vec3f& direction, float& distance)
+	{
+		const InstanceSlot& slot = m_Instances[instance];
+		Mat4& modelMatrix = m_Batches[slot.batch].transforms[slot.index];
+
+		// Bring the ray into model space with the inverse of the affine model matrix, transpose(cofactor(M)) / det(M).
+		// The ray keeps its parameter t, so the distances found in model space are the same as in world space.
+		Vec3f rows[3] = { Vec3f(modelMatrix(0, 0), modelMatrix(0, 1), modelMatrix(0, 2)),
+						  Vec3f(modelMatrix(1, 0), modelMatrix(1, 1), modelMatrix(1, 2)),
+						  Vec3f(modelMatrix(2, 0), modelMatrix(2, 1), modelMatrix(2, 2)) };
+		Vec3f cofactors[3] = { Cross(rows[1], rows[2]), Cross(rows[2], rows[0]), Cross(rows[0], rows[1]) };
+		const float determinant = Dot(rows[0], cofactors[0]);
+		if (determinant == 0.0f) return false;
+
+		const float inverseDeterminant = 1.0f / determinant;
+		Vec3f offset = origin - Vec3f(modelMatrix(0, 3), modelMatrix(1, 3), modelMatrix(2, 3));
+		Vec3f localOrigin = (cofactors[0] * offset.x + cofactors[1] * offset.y + cofactors[2] * offset.z) * inverseDeterminant;
+		Vec3f localDirection = (cofactors[0] * direction.x + cofactors[1] * direction.y + cofactors[2] * direction.z) * inverseDeterminant;
+
+		// Only instances of loaded models are bounded & reach here.
+		return m_Batches[slot.batch].model.Get()->Intersect(localOrigin, localDirection, distance);
+	}
+
+	bool Scene::Pick(const Vec3f& origin, const Vec3f& direction, size_t& instance, float& distance)
+	{
+		UpdateBvh();
+
+		distance = FLT_MAX;
+		bool hit = false;
+		uint32_t id;
+		if (m_Bvh.Raycast(origin, direction, distance, id, [&](uint32_t candidate, float& nearest) { return IntersectInstance(candidate, origin, direction, nearest); }))
+		{
+			instance = id;
+			hit = true;
+		}
+
+		// Occluders aren't in the Bvh, they are few so they are all tested.
+		const Vec3f inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+		float entry;
+		for (uint32_t candidate : m_Occluders)
+		{
+			if (!m_Batches[m_Instances[candidate].batch].bounded || !IntersectRay(m_Bounds[candidate], origin, inverseDirection, distance, entry)) continue;
+			if (IntersectInstance(candidate, origin, direction, distance))
+			{
+				instance = candidate;
+				hit = true;
+			}
+		}
+		return hit;
+	}
+}
@@ -0,0 +1,87 @@
+// Instances of models placed in the world.
+#pragma once
+
+#include "AssetLoader.h"
+#include "OcclusionBuffer.h"
+#include "Bvh.h"
+#include <vector>
+
+namespace MiniRenderer
+{
+	/// @brief Holds instances of models, each with its own transform & color. Instances of the same model share its meshes
+	/// & are kept together in one batch, so every mesh is fetched once per batch however many instances use it.
+	/// Instances are culled & picked through a Bvh over their world space boxes, so only the visible ones are visited.
+	class Scene
+	{
+	public:
+		/// @brief Adds an instance of model placed by transform & returns its index. The model may still be loading.
+		/// Occluders should be large & simple: they are drawn to a small depth buffer first, & instances hidden behind them are skipped.
+		size_t AddInstance(const ModelHandle& model, const Mat4& transform, uint32_t color = 0xFFFF00, bool occluder = false);
+
+		/// @brief Replaces the transform of the instance.
+		void SetTransform(size_t instance, const Mat4& transform);
+		const Mat4& GetTransform(size_t instance) const;
+
+		/// @brief Replaces the color of the instance.
+		void SetColor(size_t instance, uint32_t color);
+		uint32_t GetColor(size_t instance) const;
+
+		/// @brief Number of instances in the Scene.
+		size_t GetInstanceCount() const { return m_Instances.size(); }
+
+		/// @brief Draws every instance whose model has finished loading & that isn't hidden behind an occluder.
+		/// Models that failed to load are reported once & skipped, the rest of the Scene is still drawn.
+		void Draw(Framebuffer& buffer, Camera& camera);
+
+		/// @brief Finds the nearest instance hit by the ray origin + t * direction(t >= 0) among those whose model has finished loading.
+		/// Returns if one was hit, setting instance to it & distance to its t.
+		bool Pick(const Vec3f& origin, const Vec3f& direction, size_t& instance, float& distance);
+	private:
+		/// @brief Computes the world space boxes of the instances whose model has just finished loading, occluders included, & rebuilds the Bvh if instances were added.
+		void UpdateBvh();
+
+		/// @brief Returns the model of the batch once it is loaded, nullptr while it is loading or if it failed, reporting the failure once.
+		Model* GetModel(size_t batch);
+
+		/// @brief Returns if the ray origin + t * direction hits the instance nearer than distance, lowering distance to the hit.
+		bool IntersectInstance(size_t instance, const Vec3f& origin, const Vec3f& direction, float& distance);
+	private:
+		/// @brief Instances of one model, stored contiguously so they can be drawn with one call.
+		struct Batch
+		{
+			ModelHandle model;
+			bool occluder;
+			std::vector<Mat4> transforms;
+			std::vector<uint32_t> colors;
+			std::vector<uint8_t> lods;	// Level of detail every instance was drawn with last, for every mesh of the model
+			BoundingBox bounds;	// Model space box of all meshes of the model
+			bool bounded = false;	// If the model is loaded & the boxes of all instances are computed
+			bool failed = false;	// If the model failed to load & that was reported
+			std::vector<uint32_t> visible;	// Instances found visible in the frame being drawn
+		};
+
+		/// @brief Where an instance is stored.
+		struct InstanceSlot
+		{
+			size_t batch;
+			size_t index;
+		};
+
+		std::vector<Batch> m_Batches;
+		std::vector<InstanceSlot> m_Instances;
+
+		/// @brief World space box of every instance, once its model is loaded.
+		std::vector<BoundingBox> m_Bounds;
+
+		/// @brief Hierarchy over the boxes of the instances that aren't occluders, & if it has to be rebuilt.
+		Bvh m_Bvh;
+		bool m_BvhDirty = false;
+		std::vector<uint32_t> m_Visible;
+
+		/// @brief Instances that are occluders.
+		std::vector<uint32_t> m_Occluders;
+
+		/// @brief Depth of the occluders of the frame being drawn.
+		OcclusionBuffer m_Occlusion;
+	};
+}
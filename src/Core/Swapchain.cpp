@@ -9,10 +9,17 @@ namespace MiniRenderer
 		EventHandler::GetInstance()->WindowEventDispatcher.AddListener(WindowEvents::WindowResize, std::bind(&Swapchain::OnWindowEvent, this, std::placeholders::_1));
 	}
 
-	/// @brief Copies the data of Back buffer into Front buffer & shows it to the window.
+	/// @brief Copies the data of Back buffer into Front buffer & shows it to the window, the Front buffer is always linear.
 	/// If swap is set to false, then backbuffer is shown directly to the window & doesn't wait for the backbuffer to complete.
 	void Swapchain::SwapBuffers(MiniWindow* window, bool swap)
 	{
+		// Average the samples of the triangles drawn this frame into the pixels of the backbuffer.
+		backBuffer.ResolveSamples();
+
+		// Keep the alpha storage of the front buffer the same as the backbuffer's, so presenting is a plain copy.
+		if (m_FrontBuffer.IsAlphaPacked() != backBuffer.IsAlphaPacked())
+			m_FrontBuffer.EnablePackedAlpha(backBuffer.IsAlphaPacked());
+
 		if (swap)
 		{
 			// Use Double Buffers.
@@ -23,9 +30,16 @@ namespace MiniRenderer
 			// Show Front Buffer to the window.
 			window->Draw(m_FrontBuffer);
 		}
+		else if (backBuffer.GetLayout() == FramebufferLayout::Tiled)
+		{
+			// Windows can only show linear framebuffers, so resolve the tiles into the front buffer & show that.
+			m_FrontBuffer.CopyBuffers(backBuffer);
+			window->Draw(m_FrontBuffer);
+		}
 		else
 		{
-			// Show Backbuffer to the window.
+			// Show Backbuffer to the window, tiles that are still waiting on a fast clear have to be filled first.
+			backBuffer.ResolveClear();
 			window->Draw(backBuffer);
 		}
 	}
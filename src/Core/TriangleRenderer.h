@@ -18,30 +18,192 @@ namespace MiniRenderer
         return Vec3f(1.f - (u.x + u.y) / u.z, u.y / u.z, u.x / u.z);
     }
 
-    inline void DrawTriangle(Vec2i* pts, uint32_t color, Framebuffer& buffer)
+    /// @brief Bitmask of the pixels of the 4x4 block at (blockX, blockY) that lie inside [minX, maxX] x [minY, maxY].
+    inline uint16_t BlockClipMask(int blockX, int blockY, int minX, int minY, int maxX, int maxY)
     {
-        int width = buffer.GetFramebufferWidth();
-        int height = buffer.GetFramebufferHeight();
-        Vec2i bboxmin(width - 1, height - 1);
-        Vec2i bboxmax(0, 0);
-        Vec2i clamp(width - 1, height - 1);
+        uint16_t columns = 0, mask = 0;
+        for (int i = 0; i < 4; i++)
+            if (blockX + i >= minX && blockX + i <= maxX) columns |= 1 << i;
+        for (int i = 0; i < 4; i++)
+            if (blockY + i >= minY && blockY + i <= maxY) mask |= columns << (i * 4);
+        return mask;
+    }
+
+    /// @brief Draws a triangle whose bounding box [minX, maxX] x [minY, maxY], clipped to the framebuffer, is at most 4x4 pixels.
+    /// Its vertices v are wound so that the edge functions are positive inside. The pixels of the box are tested in one 4x4 window
+    /// from (minX, minY) instead of walking aligned blocks, & nothing is written if the triangle misses every sample.
+    inline void DrawSmallTriangle(const Vec2i* v, int minX, int minY, int maxX, int maxY, uint32_t color, Framebuffer& buffer)
+    {
+        const int sampleCount = buffer.GetSampleCount();
+        const float (*samplePositions)[2] = sampleCount == 4 ? SAMPLE_POSITIONS_4X : SAMPLE_POSITIONS_2X;
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 columnOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+        __m128 edgeRow[3], sampleOffsets[3][MAX_SAMPLE_COUNT];
+        float stepY[3];
         for (int i = 0; i < 3; i++)
         {
-            bboxmin.x = Max(0, Min(bboxmin.x, pts[i].x));
-            bboxmin.y = Max(0, Min(bboxmin.y, pts[i].y));
+            const Vec2i& a = v[i];
+            const Vec2i& b = v[(i + 1) % 3];
+            float A = (float)(a.y - b.y), B = (float)(b.x - a.x);
+            float C = -(A * a.x + B * a.y);
+            edgeRow[i] = _mm_add_ps(_mm_set1_ps(A * minX + B * minY + C), _mm_mul_ps(_mm_set1_ps(A), columnOffsets));
+            stepY[i] = B;
+            for (int sample = 0; sample < sampleCount; sample++)
+                sampleOffsets[i][sample] = sampleCount > 1 ? _mm_set1_ps(A * samplePositions[sample][0] + B * samplePositions[sample][1]) : zero;
+        }
+
+        uint16_t masks[MAX_SAMPLE_COUNT] = {};
+        for (int row = 0; row <= maxY - minY; row++)
+        {
+            for (int sample = 0; sample < sampleCount; sample++)
+            {
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(edgeRow[0], sampleOffsets[0][sample]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(edgeRow[1], sampleOffsets[1][sample]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(edgeRow[2], sampleOffsets[2][sample]), zero));
+                masks[sample] |= _mm_movemask_ps(inside) << (row * 4);
+            }
+            for (int i = 0; i < 3; i++)
+                edgeRow[i] = _mm_add_ps(edgeRow[i], _mm_set1_ps(stepY[i]));
+        }
+
+        // Columns past maxX can lie outside the framebuffer.
+        const uint16_t columns = (uint16_t)((1 << (maxX - minX + 1)) - 1);
+        const uint16_t clip = columns | columns << 4 | columns << 8 | columns << 12;
+        uint16_t any = 0;
+        for (int sample = 0; sample < sampleCount; sample++)
+            any |= masks[sample] &= clip;
+
+        for (int pixel = 0; pixel < 16 && any >> pixel != 0; pixel++)
+        {
+            if ((any & (1 << pixel)) == 0) continue;
+
+            int x = minX + (pixel & 3), y = minY + (pixel >> 2);
+            if (sampleCount == 1)
+            {
+                buffer.SetPixelColorUnchecked(x, y, color);
+                continue;
+            }
+
+            unsigned int covered = 0;
+            for (int sample = 0; sample < sampleCount; sample++)
+                covered |= ((masks[sample] >> pixel) & 1u) << sample;
+            buffer.WriteSamplesUnchecked(x, y, covered, color);
+        }
+    }
+
+    inline void DrawTriangle(Vec2i* pts, uint32_t color, Framebuffer& buffer)
+    {
+        // Clip the bounding box against the framebuffer once, every write after this is unchecked.
+        int minX = Max(0, Min(pts[0].x, Min(pts[1].x, pts[2].x)));
+        int minY = Max(0, Min(pts[0].y, Min(pts[1].y, pts[2].y)));
+        int maxX = Min(buffer.GetFramebufferWidth() - 1, Max(pts[0].x, Max(pts[1].x, pts[2].x)));
+        int maxY = Min(buffer.GetFramebufferHeight() - 1, Max(pts[0].y, Max(pts[1].y, pts[2].y)));
+        if (minX > maxX || minY > maxY) return;
+
+        // Twice the signed area, if it is 0 then the triangle is degenerate.
+        float area = (float)(pts[1].x - pts[0].x) * (float)(pts[2].y - pts[0].y) - (float)(pts[1].y - pts[0].y) * (float)(pts[2].x - pts[0].x);
+        if (area == 0.0f) return;
+
+        // Wind the triangle so that all edge functions are positive inside it, pixels on the edges are drawn.
+        Vec2i v[3] = { pts[0], area > 0.0f ? pts[1] : pts[2], area > 0.0f ? pts[2] : pts[1] };
+
+        // Most triangles of dense meshes only span a few pixels, their setup & block walk would cost more than testing them directly.
+        if (maxX - minX < 4 && maxY - minY < 4)
+        {
+            DrawSmallTriangle(v, minX, minY, maxX, maxY, color, buffer);
+            return;
+        }
 
-            bboxmax.x = Min(clamp.x, Max(bboxmax.x, pts[i].x));
-            bboxmax.y = Min(clamp.y, Max(bboxmax.y, pts[i].y));
+        // Multisampled framebuffers test every sample of a pixel at its offset, E(x + dx, y + dy) = E(x, y) + A * dx + B * dy.
+        // The color is the same for all of them, so the triangle is still shaded once per pixel.
+        const int sampleCount = buffer.GetSampleCount();
+        const float (*samplePositions)[2] = sampleCount == 4 ? SAMPLE_POSITIONS_4X : SAMPLE_POSITIONS_2X;
+        __m128 sampleOffsets[3][MAX_SAMPLE_COUNT];
+
+        // Edge function of the edge from a to b: E(x, y) = A * x + B * y + C.
+        __m128 stepX[3], edgeStart[3];
+        float stepY[3];
+        const __m128 columnOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        int blockStartX = minX & ~3, blockStartY = minY & ~3;
+        for (int i = 0; i < 3; i++)
+        {
+            const Vec2i& a = v[i];
+            const Vec2i& b = v[(i + 1) % 3];
+            float A = (float)(a.y - b.y), B = (float)(b.x - a.x);
+            float C = -(A * a.x + B * a.y);
+            stepX[i] = _mm_set1_ps(A * 4.0f);
+            stepY[i] = B;
+            edgeStart[i] = _mm_add_ps(_mm_set1_ps(A * blockStartX + B * blockStartY + C), _mm_mul_ps(_mm_set1_ps(A), columnOffsets));
+            for (int sample = 0; sample < sampleCount; sample++)
+                sampleOffsets[i][sample] = _mm_set1_ps(A * samplePositions[sample][0] + B * samplePositions[sample][1]);
         }
-        Vec2i P;
-        for (P.x = bboxmin.x; P.x <= bboxmax.x; P.x++)
+
+        // Walk the bounding box in 4x4 blocks, row after row, & write every block with its coverage mask.
+        const __m128 zero = _mm_setzero_ps();
+        for (int blockY = blockStartY; blockY <= maxY; blockY += 4)
         {
-            for (P.y = bboxmin.y; P.y <= bboxmax.y; P.y++)
+            __m128 edgeBlock[3] = { edgeStart[0], edgeStart[1], edgeStart[2] };
+            for (int blockX = blockStartX; blockX <= maxX; blockX += 4)
             {
-                Vec3f bc_screen = Barycentric(pts, P);
-                if (bc_screen.x < 0 || bc_screen.y < 0 || bc_screen.z < 0) continue;
-                buffer.SetPixelColor(P.x, P.y, color);
+                if (sampleCount > 1)
+                {
+                    uint16_t masks[MAX_SAMPLE_COUNT] = {};
+                    for (int row = 0; row < 4; row++)
+                    {
+                        __m128 edgeRow[3];
+                        for (int i = 0; i < 3; i++)
+                            edgeRow[i] = _mm_add_ps(edgeBlock[i], _mm_set1_ps(stepY[i] * row));
+                        for (int sample = 0; sample < sampleCount; sample++)
+                        {
+                            __m128 inside = _mm_cmpge_ps(_mm_add_ps(edgeRow[0], sampleOffsets[0][sample]), zero);
+                            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(edgeRow[1], sampleOffsets[1][sample]), zero));
+                            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(edgeRow[2], sampleOffsets[2][sample]), zero));
+                            masks[sample] |= _mm_movemask_ps(inside) << (row * 4);
+                        }
+                    }
+
+                    uint16_t any = 0;
+                    for (int sample = 0; sample < sampleCount; sample++)
+                        any |= masks[sample];
+                    if (any != 0 && (blockX < minX || blockY < minY || blockX + 3 > maxX || blockY + 3 > maxY))
+                    {
+                        uint16_t clip = BlockClipMask(blockX, blockY, minX, minY, maxX, maxY);
+                        any = 0;
+                        for (int sample = 0; sample < sampleCount; sample++)
+                            any |= masks[sample] &= clip;
+                    }
+
+                    if (any != 0)
+                        buffer.WriteSamples4x4(blockX, blockY, masks, color);
+
+                    for (int i = 0; i < 3; i++)
+                        edgeBlock[i] = _mm_add_ps(edgeBlock[i], stepX[i]);
+                    continue;
+                }
+
+                uint16_t mask = 0;
+                for (int row = 0; row < 4; row++)
+                {
+                    __m128 inside = _mm_cmpge_ps(_mm_add_ps(edgeBlock[0], _mm_set1_ps(stepY[0] * row)), zero);
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(edgeBlock[1], _mm_set1_ps(stepY[1] * row)), zero));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(edgeBlock[2], _mm_set1_ps(stepY[2] * row)), zero));
+                    mask |= _mm_movemask_ps(inside) << (row * 4);
+                }
+
+                // Blocks on the border of the bounding box can reach outside the framebuffer.
+                if (mask != 0 && (blockX < minX || blockY < minY || blockX + 3 > maxX || blockY + 3 > maxY))
+                    mask &= BlockClipMask(blockX, blockY, minX, minY, maxX, maxY);
+
+                if (mask != 0)
+                    buffer.WriteBlock4x4(blockX, blockY, mask, color);
+
+                for (int i = 0; i < 3; i++)
+                    edgeBlock[i] = _mm_add_ps(edgeBlock[i], stepX[i]);
             }
+
+            for (int i = 0; i < 3; i++)
+                edgeStart[i] = _mm_add_ps(edgeStart[i], _mm_set1_ps(stepY[i] * 4.0f));
         }
     }
 }
@@ -177,29 +177,32 @@ namespace MiniRenderer
         // Allocate Memory for our Color Buffer.
         m_BufferWidth = m_Data.Width;
         m_BufferHeight = m_Data.Height;
-        m_ColorBuffer = (unsigned char*)malloc(m_BufferWidth * m_BufferHeight * sizeof(uint32_t));
+        m_BufferStride = m_Data.Width;
+        m_ColorBuffer = (unsigned char*)malloc(m_BufferStride * m_BufferHeight * sizeof(uint32_t));
     }
 
     XImage* LinuxWindow::ImageFromBuffer(const Framebuffer& buffer, Visual *visual)
     {
         int framebufferWidth = buffer.GetFramebufferWidth();
         int framebufferHeight = buffer.GetFramebufferHeight();
+        int framebufferStride = buffer.GetFramebufferStride();
 
-        if(framebufferWidth != m_BufferWidth || framebufferHeight != m_BufferHeight)
+        if(framebufferWidth != m_BufferWidth || framebufferHeight != m_BufferHeight || framebufferStride != m_BufferStride)
         {
             // Update our color buffer size.
             m_BufferWidth = framebufferWidth;
             m_BufferHeight = framebufferHeight;
-            unsigned char* colorBuffer = (unsigned char*)realloc(m_ColorBuffer, m_BufferWidth * m_BufferHeight * sizeof(uint32_t));
+            m_BufferStride = framebufferStride;
+            unsigned char* colorBuffer = (unsigned char*)realloc(m_ColorBuffer, m_BufferStride * m_BufferHeight * sizeof(uint32_t));
             if(colorBuffer != nullptr)
                 m_ColorBuffer = colorBuffer;
             else
                 throw std::runtime_error("Failed to resize Linux window's color buffer.\n");
         }
 
-        // Copy memory of Framebuffer's color buffer to our color buffer.
-        std::memcpy(m_ColorBuffer, buffer.colorBuffer, m_BufferWidth * m_BufferHeight * sizeof(uint32_t));
-        return XCreateImage(m_Display, visual, DefaultDepth(m_Display, m_Screen), ZPixmap, 0, (char *)m_ColorBuffer, m_BufferWidth, m_BufferHeight, 32, 0);
+        // Copy memory of Framebuffer's color buffer to our color buffer, rows keep the padding of the framebuffer.
+        std::memcpy(m_ColorBuffer, buffer.colorBuffer, m_BufferStride * m_BufferHeight * sizeof(uint32_t));
+        return XCreateImage(m_Display, visual, DefaultDepth(m_Display, m_Screen), ZPixmap, 0, (char *)m_ColorBuffer, m_BufferWidth, m_BufferHeight, 32, m_BufferStride * sizeof(uint32_t));
     }
 }
 
@@ -45,6 +45,9 @@ namespace MiniRenderer
 		// Width & Height of the color buffer that will be shown to the screen.
 		int m_BufferWidth, m_BufferHeight;
 
+		// Pixels per row of the color buffer, same as the stride of the framebuffer it was copied from.
+		int m_BufferStride;
+
 		struct WindowData
 		{
 			const char* Title;
@@ -108,9 +108,10 @@ namespace MiniRenderer
 	void WindowsWindow::Draw(const Framebuffer& framebuffer)
 	{
 		// Update Bitmap Width & Height to match screen height.
-		if (framebuffer.GetFramebufferWidth() != m_BitmapInfo.bmiHeader.biWidth || -framebuffer.GetFramebufferHeight() != m_BitmapInfo.bmiHeader.biHeight)
+		// Bitmap rows are as wide as the framebuffer stride, only the visible width is copied to the window.
+		if (framebuffer.GetFramebufferStride() != m_BitmapInfo.bmiHeader.biWidth || -framebuffer.GetFramebufferHeight() != m_BitmapInfo.bmiHeader.biHeight)
 		{
-			m_BitmapInfo.bmiHeader.biWidth = framebuffer.GetFramebufferWidth();
+			m_BitmapInfo.bmiHeader.biWidth = framebuffer.GetFramebufferStride();
 			m_BitmapInfo.bmiHeader.biHeight = -framebuffer.GetFramebufferHeight();
 		}
 